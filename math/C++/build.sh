@@ -24,6 +24,19 @@ fi
 FLAGS="-std=c++23 -Wall -Wextra -Wpedantic -Werror -O3"
 mkdir -p bin/
 exe clang++ $FLAGS -x c++-module src/Vector.cc --precompile -o bin/Vector.pcm
+exe clang++ $FLAGS -x c++-module src/Matrix.cc --precompile -fprebuilt-module-path=bin/ -o bin/Matrix.pcm
+exe clang++ $FLAGS -x c++-module src/Aabb.cc --precompile -fprebuilt-module-path=bin/ -o bin/Aabb.pcm
+exe clang++ $FLAGS -x c++-module src/Approx.cc --precompile -fprebuilt-module-path=bin/ -o bin/Approx.pcm
+exe clang++ $FLAGS -x c++-module src/Storage.cc --precompile -fprebuilt-module-path=bin/ -o bin/Storage.pcm
+exe clang++ $FLAGS -x c++-module src/Cpu.cc --precompile -o bin/Cpu.pcm
+exe clang++ $FLAGS -x c++-module src/Batch.cc --precompile -fprebuilt-module-path=bin/ -o bin/Batch.pcm
 exe clang++ $FLAGS bin/Vector.pcm -fprebuilt-module-path=bin/ -c -o bin/Vector.o
-exe llvm-ar rcs libmath.a bin/Vector.o
+exe clang++ $FLAGS bin/Matrix.pcm -fprebuilt-module-path=bin/ -c -o bin/Matrix.o
+exe clang++ $FLAGS bin/Aabb.pcm -fprebuilt-module-path=bin/ -c -o bin/Aabb.o
+exe clang++ $FLAGS bin/Approx.pcm -fprebuilt-module-path=bin/ -c -o bin/Approx.o
+exe clang++ $FLAGS bin/Storage.pcm -fprebuilt-module-path=bin/ -c -o bin/Storage.o
+exe clang++ $FLAGS bin/Cpu.pcm -c -o bin/Cpu.o
+exe clang++ $FLAGS bin/Batch.pcm -fprebuilt-module-path=bin/ -c -o bin/Batch.o
+exe llvm-ar rcs libmath.a bin/Vector.o bin/Matrix.o bin/Aabb.o \
+    bin/Approx.o bin/Storage.o bin/Cpu.o bin/Batch.o
 exit 0
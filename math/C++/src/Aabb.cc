@@ -0,0 +1,340 @@
+module;
+
+#include <algorithm>
+#include <concepts>
+#include <iostream>
+#include <limits>
+
+#include <cstddef>
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+export module Aabb;
+
+import Vector;
+
+export namespace math {
+
+/**
+ * @brief Axis-aligned bounding box.
+ *
+ * Default box is empty, with minimum corner above maximum one, so union with
+ * it is identity and ray never hits it.
+ * @tparam T Arithmetic type of elements.
+ * @tparam N Number of dimensions.
+ */
+template<Arithmetic T, std::integral auto N>
+class AABB {
+private:
+    /*! @brief Minimum corner. */
+    Vector<T, N> min;
+    /*! @brief Maximum corner. */
+    Vector<T, N> max;
+
+public:
+    /*! @brief Default constructor, empty box. */
+    constexpr AABB() noexcept {
+        for(auto i = 0; i < N; ++i) {
+            min[i] = std::numeric_limits<T>::max();
+            max[i] = std::numeric_limits<T>::lowest();
+        }
+    }
+
+    /**
+     * @brief Constructor that accepts corners, empty if minimum exceeds
+     * maximum along any axis.
+     * @param min Minimum corner.
+     * @param max Maximum corner.
+     */
+    constexpr AABB(const Vector<T, N>& min, const Vector<T, N>& max) noexcept :
+        min{min}, max{max} {}
+
+    /*! @brief Get minimum corner. */
+    constexpr auto Min() const noexcept -> const Vector<T, N>& { return min; }
+
+    /*! @brief Get maximum corner. */
+    constexpr auto Max() const noexcept -> const Vector<T, N>& { return max; }
+
+    /*! @brief Check if box contains no point. */
+    constexpr auto Empty() const noexcept -> bool {
+        for(auto i = 0; i < N; ++i)
+            if(min[i] > max[i])
+                return true;
+        return false;
+    }
+
+    /*! @brief Get size along each axis. */
+    constexpr auto Extent() const noexcept -> Vector<T, N> {
+        return max - min;
+    }
+
+    /*! @brief Get center. */
+    constexpr auto Centroid() const noexcept -> Vector<T, N> {
+        return (min + max) / T{2};
+    }
+
+    /**
+     * @brief Get surface area, sum of areas of all faces.
+     *
+     * Perimeter in two dimensions, zero for empty box.
+     */
+    constexpr auto SurfaceArea() const noexcept -> T {
+        if(Empty())
+            return T{0};
+        const auto extent = Extent();
+        T area{0};
+        for(auto i = 0; i < N; ++i) {
+            T face{1};
+            for(auto j = 0; j < N; ++j)
+                if(i != j)
+                    face *= extent[j];
+            area += face;
+        }
+        return T{2} * area;
+    }
+
+    /*! @brief Get index of axis along which box is largest. */
+    constexpr auto LongestAxis() const noexcept -> int {
+        const auto extent = Extent();
+        auto axis = 0;
+        for(auto i = 1; i < N; ++i)
+            if(extent[i] > extent[axis])
+                axis = i;
+        return axis;
+    }
+
+    /**
+     * @brief Check if point lies inside or on boundary.
+     * @param point Point.
+     */
+    constexpr auto Contains(const Vector<T, N>& point) const noexcept -> bool {
+        for(auto i = 0; i < N; ++i)
+            if(point[i] < min[i] || point[i] > max[i])
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Check if boxes share at least one point.
+     * @param box Box.
+     */
+    constexpr auto Overlaps(const AABB& box) const noexcept -> bool {
+        return !Intersection(box).Empty();
+    }
+
+    /**
+     * @brief Get smallest box enclosing both boxes.
+     * @param box Box.
+     */
+    constexpr auto Union(const AABB& box) const noexcept -> AABB {
+        AABB result;
+        for(auto i = 0; i < N; ++i) {
+            result.min[i] = std::min(min[i], box.min[i]);
+            result.max[i] = std::max(max[i], box.max[i]);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Get smallest box enclosing box and point.
+     * @param point Point.
+     */
+    constexpr auto Union(const Vector<T, N>& point) const noexcept -> AABB {
+        return Union(AABB(point, point));
+    }
+
+    /**
+     * @brief Get box shared by both boxes, empty if they do not overlap.
+     * @param box Box.
+     */
+    constexpr auto Intersection(const AABB& box) const noexcept -> AABB {
+        AABB result;
+        for(auto i = 0; i < N; ++i) {
+            result.min[i] = std::max(min[i], box.min[i]);
+            result.max[i] = std::min(max[i], box.max[i]);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Intersect ray with box by branchless slab test.
+     *
+     * Ray is given by origin and reciprocal of direction, so that division
+     * happens once per ray instead of once per box.
+     * @param origin Ray origin.
+     * @param inverse_direction Reciprocal of each element of ray direction.
+     * @param t_min Start of interval along ray.
+     * @param t_max End of interval along ray.
+     * @return Distance where ray enters box, clamped to t_min, or Miss() if
+     * ray misses box within interval.
+     */
+    constexpr auto Intersect(const Vector<T, N>& origin,
+        const Vector<T, N>& inverse_direction, const T t_min,
+        const T t_max) const noexcept -> T {
+#if defined(__SSE__)
+        if constexpr(std::same_as<T, float> && N == 3) {
+            if !consteval {
+                return IntersectSse(origin, inverse_direction, t_min, t_max);
+            }
+        }
+#endif
+        auto entry = t_min;
+        auto exit = t_max;
+        for(auto i = 0; i < N; ++i) {
+            const auto t0 = (min[i] - origin[i]) * inverse_direction[i];
+            const auto t1 = (max[i] - origin[i]) * inverse_direction[i];
+            const auto near = t0 < t1 ? t0 : t1;
+            const auto far = t0 > t1 ? t0 : t1;
+            entry = near > entry ? near : entry;
+            exit = far < exit ? far : exit;
+        }
+        return Blend(entry <= exit, entry, Miss());
+    }
+
+    /*! @brief Distance reported for missed box, infinity or largest value. */
+    static constexpr auto Miss() noexcept -> T {
+        if constexpr(std::numeric_limits<T>::has_infinity)
+            return std::numeric_limits<T>::infinity();
+        else
+            return std::numeric_limits<T>::max();
+    }
+
+    /*! @brief == operator. */
+    friend constexpr bool operator==(const AABB&, const AABB&) noexcept =
+        default;
+
+    /*! @brief Output stream << operator. */
+    friend std::ostream& operator<<(std::ostream& out, const AABB& box) {
+        return out << box.min << " - " << box.max;
+    }
+
+private:
+#if defined(__SSE__)
+    /**
+     * @brief Slab test of 3D float box with all axes in one SSE register.
+     *
+     * Compilers turn scalar form into branches whenever interval bounds are
+     * constants, so this form keeps test branchless where it matters most.
+     */
+    auto IntersectSse(const Vector<T, N>& origin,
+        const Vector<T, N>& inverse_direction, const T t_min,
+        const T t_max) const noexcept -> T {
+        const auto Load = [](const Vector<T, N>& vector) {
+            return _mm_setr_ps(vector[0], vector[1], vector[2], vector[2]);
+        };
+        const auto start = Load(origin);
+        const auto inverse = Load(inverse_direction);
+        const auto t0 = _mm_mul_ps(_mm_sub_ps(Load(min), start), inverse);
+        const auto t1 = _mm_mul_ps(_mm_sub_ps(Load(max), start), inverse);
+        auto near = _mm_min_ps(t0, t1);
+        auto far = _mm_max_ps(t0, t1);
+        near = _mm_max_ps(near, _mm_shuffle_ps(near, near,
+            _MM_SHUFFLE(2, 3, 0, 1)));
+        far = _mm_min_ps(far, _mm_shuffle_ps(far, far,
+            _MM_SHUFFLE(2, 3, 0, 1)));
+        near = _mm_max_ss(_mm_movehl_ps(near, near), near);
+        far = _mm_min_ss(_mm_movehl_ps(far, far), far);
+        const auto entry = _mm_max_ss(near, _mm_set_ss(t_min));
+        const auto exit = _mm_min_ss(far, _mm_set_ss(t_max));
+        const auto hit = _mm_cmple_ss(entry, exit);
+        return _mm_cvtss_f32(_mm_or_ps(_mm_and_ps(hit, entry),
+            _mm_andnot_ps(hit, _mm_set_ss(Miss()))));
+    }
+#endif
+};
+
+/**
+ * @brief Axis-aligned bounding boxes in lanes, tested against one ray at once.
+ * @tparam T Arithmetic type of elements.
+ * @tparam N Number of dimensions.
+ * @tparam W Number of lanes.
+ */
+template<Arithmetic T, std::integral auto N, std::size_t W = LANES<T>>
+class AABBPack {
+private:
+    /*! @brief Minimum corners. */
+    VectorPack<T, N, W> min;
+    /*! @brief Maximum corners. */
+    VectorPack<T, N, W> max;
+
+public:
+    /*! @brief Default constructor, all lanes empty. */
+    AABBPack() noexcept : min{AABB<T, N>().Min()}, max{AABB<T, N>().Max()} {}
+
+    /**
+     * @brief Get box in lane.
+     * @param lane Lane index.
+     */
+    inline auto Get(const std::size_t lane) const noexcept -> AABB<T, N> {
+        return AABB<T, N>(min.Get(lane), max.Get(lane));
+    }
+
+    /**
+     * @brief Set box in lane.
+     * @param lane Lane index.
+     * @param box Box.
+     */
+    inline void Set(const std::size_t lane, const AABB<T, N>& box) noexcept {
+        min.Set(lane, box.Min());
+        max.Set(lane, box.Max());
+    }
+
+    /**
+     * @brief Intersect ray with all boxes by branchless slab test.
+     * @param origin Ray origin.
+     * @param inverse_direction Reciprocal of each element of ray direction.
+     * @param t_min Start of interval along ray.
+     * @param t_max End of interval along ray.
+     * @return Distances where ray enters each box, clamped to t_min, or
+     * AABB::Miss() in lanes whose box ray misses within interval.
+     */
+    inline auto Intersect(const Vector<T, N>& origin,
+        const Vector<T, N>& inverse_direction, const T t_min,
+        const T t_max) const noexcept -> Pack<T, W> {
+        Pack<T, W> entry(t_min);
+        Pack<T, W> exit(t_max);
+        for(auto i = 0; i < N; ++i) {
+            const Pack<T, W> start(origin[i]);
+            const Pack<T, W> inverse(inverse_direction[i]);
+            const auto t0 = (min[i] - start) * inverse;
+            const auto t1 = (max[i] - start) * inverse;
+            entry = Max(Min(t0, t1), entry);
+            exit = Min(Max(t0, t1), exit);
+        }
+        return Select(entry <= exit, entry, Pack<T, W>(AABB<T, N>::Miss()));
+    }
+};
+
+} // namespace math
+
+namespace math::detail::checks {
+
+constexpr AABB<float, 3> UNIT{Vector<float, 3>{0.0f, 0.0f, 0.0f},
+    Vector<float, 3>{1.0f, 1.0f, 1.0f}};
+constexpr AABB<float, 3> SHIFTED{Vector<float, 3>{0.5f, 0.5f, 0.5f},
+    Vector<float, 3>{1.5f, 2.0f, 1.5f}};
+
+static_assert(AABB<float, 3>().Empty() && !UNIT.Empty());
+static_assert(AABB<float, 3>(UNIT.Max(), UNIT.Min()).Empty());
+static_assert(UNIT.SurfaceArea() == 6.0f && AABB<float, 2>(Vector<float, 2>{
+    0.0f, 0.0f}, Vector<float, 2>{2.0f, 3.0f}).SurfaceArea() == 10.0f);
+static_assert(UNIT.Union(AABB<float, 3>()) == UNIT);
+static_assert(UNIT.Union(SHIFTED).Extent() == Vector<float, 3>{1.5f, 2.0f,
+    1.5f});
+static_assert(UNIT.Intersection(SHIFTED).Centroid() == Vector<float, 3>{
+    0.75f, 0.75f, 0.75f});
+static_assert(SHIFTED.LongestAxis() == 1 && UNIT.Overlaps(SHIFTED));
+static_assert(!UNIT.Overlaps(AABB<float, 3>(Vector<float, 3>{2.0f, 2.0f,
+    2.0f}, Vector<float, 3>{3.0f, 3.0f, 3.0f})));
+static_assert(UNIT.Contains(Vector<float, 3>{1.0f, 0.5f, 0.0f}));
+static_assert(UNIT.Intersect(Vector<float, 3>{-1.0f, 0.5f, 0.5f},
+    Vector<float, 3>{1.0f, std::numeric_limits<float>::infinity(),
+    std::numeric_limits<float>::infinity()}, 0.0f, 10.0f) == 1.0f);
+static_assert(UNIT.Intersect(Vector<float, 3>{-1.0f, 2.0f, 0.5f},
+    Vector<float, 3>{1.0f, std::numeric_limits<float>::infinity(),
+    std::numeric_limits<float>::infinity()}, 0.0f, 10.0f) ==
+    std::numeric_limits<float>::infinity());
+
+} // namespace math::detail::checks
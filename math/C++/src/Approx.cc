@@ -0,0 +1,275 @@
+module;
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
+
+export module Approx;
+
+import Vector;
+
+export namespace math {
+
+/**
+ * @brief Raise to integer power by repeated squaring.
+ *
+ * Exact up to rounding of the few multiplications it takes, and usable in
+ * constant expressions, unlike std::pow.
+ * @tparam E Exponent.
+ * @tparam T Arithmetic type.
+ * @param base Base.
+ */
+template<int E, Arithmetic T>
+constexpr auto Pow(const T base) noexcept -> T {
+    if constexpr(E < 0) {
+        return T{1} / Pow<-E>(base);
+    } else if constexpr(E == 0) {
+        return T{1};
+    } else if constexpr(E == 1) {
+        return base;
+    } else {
+        const auto half = Pow<E / 2>(base);
+        if constexpr(E % 2 == 0)
+            return half * half;
+        else
+            return half * half * base;
+    }
+}
+
+/*!
+ * @brief Exact math policy.
+ *
+ * Forwards to standard library, so results match plain calls bit for bit.
+ */
+struct Exact {
+    /*! @brief Square root. */
+    template<Arithmetic T>
+    static constexpr auto Sqrt(const T value) noexcept -> T {
+        return math::Sqrt(value);
+    }
+
+    /*! @brief Reciprocal square root. */
+    template<Arithmetic T>
+    static constexpr auto Rsqrt(const T value) noexcept -> T {
+        return T{1} / math::Sqrt(value);
+    }
+
+    /*! @brief Base raised to exponent. */
+    template<Arithmetic T>
+    static auto Pow(const T base, const T exponent) noexcept -> T {
+        return std::pow(base, exponent);
+    }
+
+    /*! @brief Tangent. */
+    template<Arithmetic T>
+    static auto Tan(const T angle) noexcept -> T {
+        return std::tan(angle);
+    }
+
+    /*! @brief Normalize vector. */
+    template<Arithmetic T, std::integral auto N>
+    static constexpr auto Normalize(const Vector<T, N>& vector) noexcept
+        -> Vector<T, N> {
+        return vector.Normalize();
+    }
+};
+
+/*!
+ * @brief Fast approximate math policy.
+ *
+ * Single precision only, other types fall back to Exact. Bounds below are
+ * maximum relative errors measured over the stated domains. Only Log2 is
+ * free of branches, and GCC vectorizes loops over it only with
+ * -fno-trapping-math, since otherwise it won't evaluate both sides of its
+ * mantissa select. Exp2 and Tan branch out early for NaN, Rsqrt uses scalar
+ * hardware estimate, and Sqrt and Pow build on those, so loops over them
+ * stay scalar.
+ */
+struct Fast {
+    /**
+     * @brief Reciprocal square root.
+     *
+     * Hardware estimate refined by one Newton step where SSE is available,
+     * bit-level estimate refined by two Newton steps elsewhere, and by
+     * three in constant evaluation. Relative error is below 3e-7 with SSE and
+     * 5e-6 without, for positive normal values.
+     * @param value Value.
+     */
+    template<Arithmetic T>
+    static constexpr auto Rsqrt(const T value) noexcept -> T {
+        if constexpr(!std::same_as<T, float>) {
+            return Exact::Rsqrt(value);
+        } else {
+            const auto Step = [value](const float estimate) {
+                return estimate * (1.5f - 0.5f * value * estimate * estimate);
+            };
+            const auto Bits = [value] {
+                return std::bit_cast<float>(std::uint32_t{0x5f375a86} -
+                    (std::bit_cast<std::uint32_t>(value) >> 1));
+            };
+            if consteval {
+                return Step(Step(Step(Bits())));
+            } else {
+#if defined(__SSE__)
+                return Step(_mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(value))));
+#else
+                return Step(Step(Bits()));
+#endif
+            }
+        }
+    }
+
+    /**
+     * @brief Square root as value times its reciprocal square root.
+     *
+     * Same relative error as Rsqrt, zero for values that are not positive.
+     * @param value Value.
+     */
+    template<Arithmetic T>
+    static constexpr auto Sqrt(const T value) noexcept -> T {
+        if constexpr(!std::same_as<T, float>)
+            return Exact::Sqrt(value);
+        else
+            return value > 0.0f ? value * Rsqrt(value) : 0.0f;
+    }
+
+    /**
+     * @brief Base-2 logarithm.
+     *
+     * Mantissa is centered on one and fed to odd atanh series of degree
+     * nine. Relative error is below 2e-7 away from one, absolute error below
+     * 1e-7 near one, for positive normal values.
+     * @param value Value.
+     */
+    static constexpr auto Log2(const float value) noexcept -> float {
+        const auto bits = std::bit_cast<std::uint32_t>(value);
+        const auto whole = std::bit_cast<float>((bits & 0x007fffffu) |
+            0x3f800000u);
+        const auto high = whole > 1.41421356f;
+        const auto mantissa = whole * (high ? 0.5f : 1.0f);
+        const auto exponent = static_cast<int>(bits >> 23) - 127 + high;
+        const auto t = (mantissa - 1.0f) / (mantissa + 1.0f);
+        const auto t2 = t * t;
+        const auto series = t * (2.88539008f + t2 * (0.961796694f +
+            t2 * (0.577078016f + t2 * (0.412198583f + t2 * 0.320598898f))));
+        return static_cast<float>(exponent) + series;
+    }
+
+    /**
+     * @brief Base-2 exponential.
+     *
+     * Fraction is reduced to [-0.5, 0.5] and fed to Taylor polynomial of
+     * degree seven. Relative error is below 2e-7 within [-126, 127.5],
+     * below that results flush to zero and above saturate to infinity. NaN
+     * stays NaN.
+     * @param value Value.
+     */
+    static constexpr auto Exp2(const float value) noexcept -> float {
+        if(!(value == value))
+            return value;
+        const auto clamped = std::min(std::max(value, -127.0f), 128.0f);
+        const auto whole = static_cast<int>(clamped + (clamped < 0.0f ?
+            -0.5f : 0.5f));
+        const auto x = (clamped - static_cast<float>(whole)) * 0.693147181f;
+        const auto fraction = 1.0f + x * (1.0f + x * (0.5f + x *
+            (1.66666667e-1f + x * (4.16666667e-2f + x * (8.33333333e-3f +
+            x * (1.38888889e-3f + x * 1.98412698e-4f))))));
+        return fraction * std::bit_cast<float>(
+            static_cast<std::uint32_t>(whole + 127) << 23);
+    }
+
+    /**
+     * @brief Base raised to exponent, as exponential of logarithm.
+     *
+     * Relative error grows with magnitude of exponent times logarithm of
+     * base, and is below 1e-6 while that product stays within 8. Zero for
+     * bases that are not positive.
+     * @param base Base.
+     * @param exponent Exponent.
+     */
+    template<Arithmetic T>
+    static constexpr auto Pow(const T base, const T exponent) noexcept -> T {
+        if constexpr(!std::same_as<T, float>)
+            return Exact::Pow(base, exponent);
+        else
+            return base > 0.0f ? Exp2(exponent * Log2(base)) : 0.0f;
+    }
+
+    /**
+     * @brief Tangent.
+     *
+     * Angle is reduced to [-pi/4, pi/4] by multiple of pi/2, then tangent
+     * is ratio of sine and cosine series, flipped to minus cotangent for odd
+     * multiples. Relative error is below 3e-7 within (-pi/2, pi/2). Error
+     * of reduction grows with angle, so larger angles lose accuracy near
+     * poles, and beyond about 1e9 all of it. NaN stays NaN.
+     * @param angle Angle in radians.
+     */
+    template<Arithmetic T>
+    static constexpr auto Tan(const T angle) noexcept -> T {
+        if constexpr(!std::same_as<T, float>) {
+            return Exact::Tan(angle);
+        } else {
+            if(!(angle == angle))
+                return angle;
+            // Bounded to fit int, quotients that large are whole already
+            const auto quotient = std::min(std::max(angle * 0.636619772f,
+                -0x1p30f), 0x1p30f);
+            const auto multiple = static_cast<int>(quotient +
+                (quotient < 0.0f ? -0.5f : 0.5f));
+            const auto k = static_cast<float>(multiple);
+            const auto x = (angle - k * 1.5703125f) - k * 4.83826794e-4f;
+            const auto x2 = x * x;
+            const auto sine = x * (1.0f + x2 * (-1.66666667e-1f + x2 *
+                (8.33333333e-3f + x2 * (-1.98412698e-4f + x2 *
+                2.75573192e-6f))));
+            const auto cosine = 1.0f + x2 * (-0.5f + x2 * (4.16666667e-2f +
+                x2 * (-1.38888889e-3f + x2 * (2.48015873e-5f + x2 *
+                -2.75573192e-7f))));
+            const auto odd = (multiple & 1) != 0;
+            return (odd ? -cosine : sine) / (odd ? sine : cosine);
+        }
+    }
+
+    /**
+     * @brief Normalize vector by multiplying it with reciprocal square root
+     * of its squared length.
+     * @param vector Vector.
+     */
+    template<Arithmetic T, std::integral auto N>
+    static constexpr auto Normalize(const Vector<T, N>& vector) noexcept
+        -> Vector<T, N> {
+        return vector * Rsqrt(vector.Length2());
+    }
+};
+
+} // namespace math
+
+namespace math::detail::checks {
+
+/*! @brief Check that floats are within absolute tolerance. */
+constexpr auto Close(const float left, const float right) noexcept {
+    return Abs(left - right) < 1e-6f;
+}
+
+static_assert(Pow<0>(3.0f) == 1.0f && Pow<1>(3.0f) == 3.0f);
+static_assert(Pow<5>(2.0f) == 32.0f && Pow<-2>(2.0) == 0.25 && Pow<3>(3) == 27);
+static_assert(Close(Fast::Rsqrt(4.0f), 0.5f) && Close(Fast::Sqrt(9.0f), 3.0f));
+static_assert(Fast::Sqrt(0.0f) == 0.0f && Fast::Sqrt(-1.0f) == 0.0f);
+static_assert(Close(Fast::Log2(8.0f), 3.0f) && Close(Fast::Log2(1.0f), 0.0f));
+static_assert(Close(Fast::Exp2(-2.0f), 0.25f) && Close(Fast::Exp2(0.5f),
+    1.41421356f));
+static_assert(Close(Fast::Pow(2.0f, 10.0f) / 1024.0f, 1.0f));
+static_assert(Close(Fast::Tan(0.0f), 0.0f) && Close(Fast::Tan(0.785398163f),
+    1.0f));
+static_assert(Close(Fast::Normalize(Vector<float, 3>{0.0f, 3.0f, 4.0f})
+    .Length(), 1.0f));
+
+} // namespace math::detail::checks
@@ -0,0 +1,457 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <execution>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MATH_TARGET(isa) [[gnu::target(isa), gnu::flatten]]
+#else
+#define MATH_TARGET(isa) [[gnu::flatten]]
+#endif
+
+export module Batch;
+
+import Cpu;
+import Matrix;
+import Vector;
+
+namespace math::batch::detail {
+
+using Vector3f = Vector<float, 3>;
+using Matrix4f = Matrix<float, 4, 4>;
+
+/**
+ * @brief Normalize vectors in place, W at a time.
+ * @tparam W Number of lanes.
+ * @param vectors Vectors.
+ */
+template<std::size_t W>
+inline void Normalize(const std::span<Vector3f> vectors) noexcept {
+    auto i = std::size_t{0};
+    for(; i + W <= vectors.size(); i += W) {
+        VectorPack<float, 3, W> pack;
+        for(std::size_t lane = 0; lane < W; ++lane)
+            pack.Set(lane, vectors[i + lane]);
+        pack = pack.Normalize();
+        for(std::size_t lane = 0; lane < W; ++lane)
+            vectors[i + lane] = pack.Get(lane);
+    }
+    for(; i < vectors.size(); ++i)
+        vectors[i] = vectors[i].Normalize();
+}
+
+/**
+ * @brief Compute dot products of pairs of vectors, W at a time.
+ * @tparam W Number of lanes.
+ * @param left First vectors.
+ * @param right Second vectors.
+ * @param output Dot products, as many as there are first vectors.
+ */
+template<std::size_t W>
+inline void Dot(const std::span<const Vector3f> left,
+    const std::span<const Vector3f> right,
+    const std::span<float> output) noexcept {
+    auto i = std::size_t{0};
+    for(; i + W <= left.size(); i += W) {
+        VectorPack<float, 3, W> a, b;
+        for(std::size_t lane = 0; lane < W; ++lane) {
+            a.Set(lane, left[i + lane]);
+            b.Set(lane, right[i + lane]);
+        }
+        const auto dot = a.Dot(b);
+        for(std::size_t lane = 0; lane < W; ++lane)
+            output[i + lane] = dot[lane];
+    }
+    for(; i < left.size(); ++i)
+        output[i] = left[i].Dot(right[i]);
+}
+
+/*
+ * One copy of each kernel per instruction set level. Every copy is flattened,
+ * so lane-parallel code inlined into it is compiled for its level, with lanes
+ * as wide as registers of that level.
+ */
+
+using NormalizeKernel = void(std::span<Vector3f>) noexcept;
+using DotKernel = void(std::span<const Vector3f>, std::span<const Vector3f>,
+    std::span<float>) noexcept;
+using TransformKernel = void(const Matrix4f&, std::span<const Vector3f>,
+    std::span<Vector3f>) noexcept;
+
+[[gnu::flatten]] void NormalizeBaseline(
+    const std::span<Vector3f> vectors) noexcept {
+    Normalize<LANES<float>>(vectors);
+}
+
+MATH_TARGET("sse4.2") void NormalizeSse42(
+    const std::span<Vector3f> vectors) noexcept {
+    Normalize<4>(vectors);
+}
+
+MATH_TARGET("avx2,fma") void NormalizeAvx2(
+    const std::span<Vector3f> vectors) noexcept {
+    Normalize<8>(vectors);
+}
+
+MATH_TARGET("avx512f") void NormalizeAvx512(
+    const std::span<Vector3f> vectors) noexcept {
+    Normalize<16>(vectors);
+}
+
+[[gnu::flatten]] void DotBaseline(const std::span<const Vector3f> left,
+    const std::span<const Vector3f> right,
+    const std::span<float> output) noexcept {
+    Dot<LANES<float>>(left, right, output);
+}
+
+MATH_TARGET("sse4.2") void DotSse42(const std::span<const Vector3f> left,
+    const std::span<const Vector3f> right,
+    const std::span<float> output) noexcept {
+    Dot<4>(left, right, output);
+}
+
+MATH_TARGET("avx2,fma") void DotAvx2(const std::span<const Vector3f> left,
+    const std::span<const Vector3f> right,
+    const std::span<float> output) noexcept {
+    Dot<8>(left, right, output);
+}
+
+MATH_TARGET("avx512f") void DotAvx512(const std::span<const Vector3f> left,
+    const std::span<const Vector3f> right,
+    const std::span<float> output) noexcept {
+    Dot<16>(left, right, output);
+}
+
+[[gnu::flatten]] void TransformBaseline(const Matrix4f& matrix,
+    const std::span<const Vector3f> input,
+    const std::span<Vector3f> output) noexcept {
+    math::Transform<float, LANES<float>>(matrix, input, output);
+}
+
+MATH_TARGET("sse4.2") void TransformSse42(const Matrix4f& matrix,
+    const std::span<const Vector3f> input,
+    const std::span<Vector3f> output) noexcept {
+    math::Transform<float, 4>(matrix, input, output);
+}
+
+MATH_TARGET("avx2,fma") void TransformAvx2(const Matrix4f& matrix,
+    const std::span<const Vector3f> input,
+    const std::span<Vector3f> output) noexcept {
+    math::Transform<float, 8>(matrix, input, output);
+}
+
+MATH_TARGET("avx512f") void TransformAvx512(const Matrix4f& matrix,
+    const std::span<const Vector3f> input,
+    const std::span<Vector3f> output) noexcept {
+    math::Transform<float, 16>(matrix, input, output);
+}
+
+/*! @brief Normalization kernels. */
+inline constexpr cpu::Kernels<NormalizeKernel> NORMALIZE{NormalizeBaseline,
+    NormalizeSse42, NormalizeAvx2, NormalizeAvx512};
+
+/*! @brief Dot product kernels. */
+inline constexpr cpu::Kernels<DotKernel> DOT{DotBaseline, DotSse42, DotAvx2,
+    DotAvx512};
+
+/*! @brief Point transformation kernels. */
+inline constexpr cpu::Kernels<TransformKernel> TRANSFORM{TransformBaseline,
+    TransformSse42, TransformAvx2, TransformAvx512};
+
+} // namespace math::batch::detail
+
+export namespace math::batch {
+
+/*! @brief Number of elements below which kernels run sequentially. */
+inline constexpr std::size_t THRESHOLD = 1 << 14;
+
+/**
+ * @brief Run function with execution policy suited to number of elements.
+ * @param size Number of elements.
+ * @param function Function that accepts execution policy.
+ */
+template<typename F>
+inline auto Execute(const std::size_t size, F function) {
+    if(size < THRESHOLD)
+        return function(std::execution::seq);
+    return function(std::execution::par_unseq);
+}
+
+/**
+ * @brief Run function on consecutive blocks of elements, in parallel if
+ * there is more than one block.
+ * @param size Number of elements.
+ * @param function Function that accepts index of first element of block and
+ * number of elements in block.
+ */
+template<typename F>
+inline void ForEachBlock(const std::size_t size, F function) {
+    const auto count = (size + THRESHOLD - 1) / THRESHOLD;
+    if(count < 2) {
+        function(std::size_t{0}, size);
+        return;
+    }
+    std::vector<std::size_t> blocks(count);
+    std::iota(blocks.begin(), blocks.end(), std::size_t{0});
+    std::for_each(std::execution::par, blocks.begin(), blocks.end(),
+        [&](const std::size_t block) {
+            const auto first = block * THRESHOLD;
+            function(first, std::min(THRESHOLD, size - first));
+        });
+}
+
+/**
+ * @brief Normalize all vectors in place.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param vectors Vectors.
+ */
+template<Arithmetic T, std::integral auto N>
+inline void Normalize(const std::span<Vector<T, N>> vectors) {
+    Execute(vectors.size(), [&](const auto& policy) {
+        std::transform(policy, vectors.begin(), vectors.end(),
+            vectors.begin(), [](const auto& vector) {
+                return vector.Normalize(); });
+    });
+}
+
+/**
+ * @brief Normalize all vectors in place with kernel compiled for active
+ * instruction set level.
+ * @param vectors Vectors.
+ */
+inline void Normalize(const std::span<Vector<float, 3>> vectors) {
+    const auto kernel = detail::NORMALIZE.Select();
+    ForEachBlock(vectors.size(), [&](const auto first, const auto count) {
+        kernel(vectors.subspan(first, count));
+    });
+}
+
+/**
+ * @brief Normalize all vectors stored as structure of arrays in place.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param components Component arrays, as many vectors as shortest holds.
+ */
+template<Arithmetic T, std::size_t N>
+inline void Normalize(const std::array<std::span<T>, N>& components) {
+    auto size = components[0].size();
+    for(const auto& array : components)
+        size = std::min(size, array.size());
+    ForEachBlock(size, [&](const auto first, const auto count) {
+        for(auto j = first; j < first + count; ++j) {
+            T length2{0};
+            for(std::size_t i = 0; i < N; ++i)
+                length2 += components[i][j] * components[i][j];
+            const auto multiplier = T{1} / Sqrt(length2);
+            for(std::size_t i = 0; i < N; ++i)
+                components[i][j] *= multiplier;
+        }
+    });
+}
+
+/**
+ * @brief Compute dot products of pairs of vectors.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param left First vectors.
+ * @param right Second vectors.
+ * @param output Dot products.
+ */
+template<Arithmetic T, std::integral auto N>
+inline void Dot(const std::span<const Vector<T, N>> left,
+    const std::span<const Vector<T, N>> right, const std::span<T> output) {
+    const auto size = std::min({left.size(), right.size(), output.size()});
+    Execute(size, [&](const auto& policy) {
+        std::transform(policy, left.begin(), left.begin() + size,
+            right.begin(), output.begin(), [](const auto& a, const auto& b) {
+                return a.Dot(b); });
+    });
+}
+
+/**
+ * @brief Compute dot products of pairs of vectors with kernel compiled for
+ * active instruction set level.
+ * @param left First vectors.
+ * @param right Second vectors.
+ * @param output Dot products.
+ */
+inline void Dot(const std::span<const Vector<float, 3>> left,
+    const std::span<const Vector<float, 3>> right,
+    const std::span<float> output) {
+    const auto size = std::min({left.size(), right.size(), output.size()});
+    const auto kernel = detail::DOT.Select();
+    ForEachBlock(size, [&](const auto first, const auto count) {
+        kernel(left.subspan(first, count), right.subspan(first, count),
+            output.subspan(first, count));
+    });
+}
+
+/**
+ * @brief Compute dot products of pairs of vectors stored as structure of
+ * arrays.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param left Component arrays of first vectors.
+ * @param right Component arrays of second vectors.
+ * @param output Dot products, as many as shortest array holds.
+ */
+template<Arithmetic T, std::size_t N>
+inline void Dot(const std::array<std::span<const T>, N>& left,
+    const std::array<std::span<const T>, N>& right, const std::span<T> output) {
+    auto size = output.size();
+    for(std::size_t i = 0; i < N; ++i)
+        size = std::min({size, left[i].size(), right[i].size()});
+    ForEachBlock(size, [&](const auto first, const auto count) {
+        for(auto j = first; j < first + count; ++j) {
+            T sum{0};
+            for(std::size_t i = 0; i < N; ++i)
+                sum += left[i][j] * right[i][j];
+            output[j] = sum;
+        }
+    });
+}
+
+/**
+ * @brief Add pairs of vectors.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param left First vectors.
+ * @param right Second vectors.
+ * @param output Sums, may alias either input.
+ */
+template<Arithmetic T, std::integral auto N>
+inline void Add(const std::span<const Vector<T, N>> left,
+    const std::span<const Vector<T, N>> right,
+    const std::span<Vector<T, N>> output) {
+    const auto size = std::min({left.size(), right.size(), output.size()});
+    Execute(size, [&](const auto& policy) {
+        std::transform(policy, left.begin(), left.begin() + size,
+            right.begin(), output.begin(), std::plus<>{});
+    });
+}
+
+/**
+ * @brief Add vector to all vectors in place.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param vectors Vectors.
+ * @param offset Vector to add.
+ */
+template<Arithmetic T, std::integral auto N>
+inline void Add(const std::span<Vector<T, N>> vectors,
+    const Vector<T, N>& offset) {
+    Execute(vectors.size(), [&](const auto& policy) {
+        std::transform(policy, vectors.begin(), vectors.end(),
+            vectors.begin(), [&offset](const auto& vector) {
+                return vector + offset; });
+    });
+}
+
+/**
+ * @brief Scale all vectors in place.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param vectors Vectors.
+ * @param multiplier Multiplier.
+ */
+template<Arithmetic T, std::integral auto N>
+inline void Scale(const std::span<Vector<T, N>> vectors, const T multiplier) {
+    Execute(vectors.size(), [&](const auto& policy) {
+        std::transform(policy, vectors.begin(), vectors.end(),
+            vectors.begin(), [multiplier](const auto& vector) {
+                return vector * multiplier; });
+    });
+}
+
+/**
+ * @brief Linearly interpolate pairs of vectors.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param from Vectors at zero.
+ * @param to Vectors at one.
+ * @param factor Interpolation factor.
+ * @param output Interpolated vectors, may alias either input.
+ */
+template<Arithmetic T, std::integral auto N>
+inline void Lerp(const std::span<const Vector<T, N>> from,
+    const std::span<const Vector<T, N>> to, const T factor,
+    const std::span<Vector<T, N>> output) {
+    const auto size = std::min({from.size(), to.size(), output.size()});
+    Execute(size, [&](const auto& policy) {
+        std::transform(policy, from.begin(), from.begin() + size, to.begin(),
+            output.begin(), [factor](const auto& a, const auto& b) {
+                return Vector<T, N>(Lazy(a) + (Lazy(b) - a) * factor); });
+    });
+}
+
+/**
+ * @brief Transform points by homogeneous matrix with kernel compiled for
+ * active instruction set level.
+ * @param matrix Matrix.
+ * @param input Points.
+ * @param output Transformed points after perspective division, may alias
+ * input.
+ */
+inline void Transform(const Matrix<float, 4, 4>& matrix,
+    const std::span<const Vector<float, 3>> input,
+    const std::span<Vector<float, 3>> output) {
+    const auto size = std::min(input.size(), output.size());
+    const auto kernel = detail::TRANSFORM.Select();
+    ForEachBlock(size, [&](const auto first, const auto count) {
+        kernel(matrix, input.subspan(first, count),
+            output.subspan(first, count));
+    });
+}
+
+/**
+ * @brief Transform points by homogeneous matrix in place with kernel
+ * compiled for active instruction set level.
+ * @param matrix Matrix.
+ * @param points Points.
+ */
+inline void Transform(const Matrix<float, 4, 4>& matrix,
+    const std::span<Vector<float, 3>> points) {
+    Transform(matrix, std::span<const Vector<float, 3>>(points), points);
+}
+
+/**
+ * @brief Compute component-wise minimum and maximum of all vectors.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param vectors Vectors.
+ * @return Pair of minimum and maximum corners of bounding box.
+ */
+template<Arithmetic T, std::integral auto N>
+inline auto Bounds(const std::span<const Vector<T, N>> vectors)
+    -> std::pair<Vector<T, N>, Vector<T, N>> {
+    using Box = std::pair<Vector<T, N>, Vector<T, N>>;
+    Box empty;
+    for(auto i = 0; i < N; ++i) {
+        empty.first[i] = std::numeric_limits<T>::max();
+        empty.second[i] = std::numeric_limits<T>::lowest();
+    }
+    return Execute(vectors.size(), [&](const auto& policy) {
+        return std::transform_reduce(policy, vectors.begin(), vectors.end(),
+            empty, [](const Box& a, const Box& b) {
+                Box result;
+                for(auto i = 0; i < N; ++i) {
+                    result.first[i] = std::min(a.first[i], b.first[i]);
+                    result.second[i] = std::max(a.second[i], b.second[i]);
+                }
+                return result;
+            }, [](const auto& vector) { return Box{vector, vector}; });
+    });
+}
+
+} // namespace math::batch
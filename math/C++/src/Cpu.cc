@@ -0,0 +1,127 @@
+module;
+
+#include <atomic>
+#include <string_view>
+
+#include <cstdlib>
+
+export module Cpu;
+
+export namespace math::cpu {
+
+/*! @brief Instruction set level, ordered from oldest to newest. */
+enum class Level {
+    BASELINE, SSE42, AVX2, AVX512
+};
+
+/**
+ * @brief Get name of instruction set level.
+ * @param level Level.
+ */
+[[nodiscard]] auto Name(const Level level) noexcept -> std::string_view {
+    switch(level) {
+    case Level::SSE42:
+        return "sse4.2";
+    case Level::AVX2:
+        return "avx2";
+    case Level::AVX512:
+        return "avx512";
+    default:
+        return "baseline";
+    }
+}
+
+/*! @brief Detect highest instruction set level supported by this CPU. */
+[[nodiscard]] auto Detect() noexcept -> Level {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        return Level::AVX512;
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return Level::AVX2;
+    if(__builtin_cpu_supports("sse4.2"))
+        return Level::SSE42;
+#endif
+    return Level::BASELINE;
+}
+
+} // namespace math::cpu
+
+namespace math::cpu {
+
+/**
+ * @brief Level selected at startup.
+ *
+ * Detected level, lowered by MATH_CPU_LEVEL environment variable if it
+ * names an older level.
+ */
+auto Initial() noexcept -> Level {
+    const auto detected = Detect();
+    const auto variable = std::getenv("MATH_CPU_LEVEL");
+    if(!variable)
+        return detected;
+    for(const auto level : {Level::BASELINE, Level::SSE42, Level::AVX2,
+        Level::AVX512})
+        if(Name(level) == variable && level < detected)
+            return level;
+    return detected;
+}
+
+/*! @brief Level kernels are currently dispatched to. */
+auto Current() noexcept -> std::atomic<Level>& {
+    static std::atomic<Level> level{Initial()};
+    return level;
+}
+
+} // namespace math::cpu
+
+export namespace math::cpu {
+
+/*! @brief Get level kernels are currently dispatched to. */
+[[nodiscard]] auto Active() noexcept -> Level {
+    return Current().load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Force kernels to level, for benchmarking.
+ *
+ * Levels newer than detected one are lowered to it.
+ * @param level Level.
+ */
+void Force(const Level level) noexcept {
+    const auto detected = Detect();
+    Current().store(level < detected ? level : detected,
+        std::memory_order_relaxed);
+}
+
+/**
+ * @brief Table of one kernel compiled for each instruction set level.
+ * @tparam F Function type of kernel.
+ */
+template<typename F>
+struct Kernels {
+    /*! @brief Kernel for baseline of build. */
+    F* baseline;
+    /*! @brief Kernel for SSE4.2. */
+    F* sse42;
+    /*! @brief Kernel for AVX2 with FMA. */
+    F* avx2;
+    /*! @brief Kernel for AVX-512. */
+    F* avx512;
+
+    /*! @brief Select kernel for active level. */
+    [[nodiscard]] inline auto Select() const noexcept -> F* {
+        switch(Active()) {
+        case Level::AVX512:
+            return avx512;
+        case Level::AVX2:
+            return avx2;
+        case Level::SSE42:
+            return sse42;
+        default:
+            return baseline;
+        }
+    }
+};
+
+} // namespace math::cpu
@@ -0,0 +1,382 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <cmath>
+#include <cstddef>
+
+export module Matrix;
+
+import Vector;
+
+/*! @brief Matrix error. */
+class MatrixError : public std::logic_error {
+public:
+    /*! @brief Constructor. */
+    MatrixError(const std::string& message) : std::logic_error(message) {}
+};
+
+export namespace math {
+
+/**
+ * @brief Matrix stored as rows.
+ * @tparam T Arithmetic type of elements.
+ * @tparam R Positive number of rows.
+ * @tparam C Positive number of columns.
+ */
+template<Arithmetic T, std::integral auto R, std::integral auto C>
+    requires (R > 0 && C > 0)
+class Matrix {
+private:
+    /*! @brief Number of rows. */
+    static constexpr auto ROWS = static_cast<std::size_t>(R);
+    /*! @brief Number of columns. */
+    static constexpr auto COLUMNS = static_cast<std::size_t>(C);
+
+    /*! @brief Rows. */
+    std::array<Vector<T, C>, R> rows;
+
+public:
+    /*! @brief Default constructor. */
+    constexpr Matrix() noexcept = default;
+
+    /*! @brief Copy constructor. */
+    constexpr Matrix(const Matrix&) noexcept = default;
+
+    /*! @brief Move constructor. */
+    constexpr Matrix(Matrix&&) noexcept = default;
+
+    /*! @brief Destructor. */
+    constexpr ~Matrix() noexcept = default;
+
+    /**
+     * @brief Constructor that accepts rows.
+     * @param arguments Rows.
+     */
+    template<typename... Args>
+        requires (sizeof...(Args) == R &&
+            (std::convertible_to<Args, Vector<T, C>> && ...))
+    constexpr Matrix(const Args&... arguments) noexcept : rows{arguments...} {}
+
+    /*! @brief Copy assignment operator. */
+    constexpr Matrix& operator=(const Matrix&) noexcept = default;
+
+    /*! @brief Move assignment operator. */
+    constexpr Matrix& operator=(Matrix&&) noexcept = default;
+
+    /*! @brief Create matrix filled with zeros. */
+    [[nodiscard]] static constexpr auto Zero() noexcept -> Matrix {
+        Matrix result;
+        for(auto& row : result.rows)
+            for(auto& value : row)
+                value = T{0};
+        return result;
+    }
+
+    /*! @brief Create identity matrix. */
+    [[nodiscard]] static constexpr auto Identity() noexcept -> Matrix {
+        static_assert(R == C);
+        auto result = Zero();
+        for(std::size_t i = 0; i < ROWS; ++i)
+            result.rows[i][i] = T{1};
+        return result;
+    }
+
+    /*! @brief Subscript operator to access row. */
+    constexpr auto operator[](const std::size_t row) const noexcept
+        -> const Vector<T, C>& {
+        return rows[row];
+    }
+
+    /*! @brief Subscript operator to access row. */
+    constexpr auto& operator[](const std::size_t row) noexcept {
+        return rows[row];
+    }
+
+    /**
+     * @brief Get column.
+     * @param column Column index.
+     */
+    constexpr auto Column(const std::size_t column) const noexcept
+        -> Vector<T, R> {
+        Vector<T, R> result;
+        for(std::size_t i = 0; i < ROWS; ++i)
+            result[i] = rows[i][column];
+        return result;
+    }
+
+    /*! @brief Compute transpose. */
+    constexpr auto Transpose() const noexcept -> Matrix<T, C, R> {
+        Matrix<T, C, R> result;
+        for(std::size_t i = 0; i < COLUMNS; ++i)
+            result[i] = Column(i);
+        return result;
+    }
+
+    /*! @brief Compute determinant by Gaussian elimination. */
+    constexpr auto Determinant() const noexcept -> T {
+        static_assert(R == C);
+        auto matrix = *this;
+        T result{1};
+        for(std::size_t i = 0; i < ROWS; ++i) {
+            const auto pivot = matrix.Pivot(i);
+            if(matrix.rows[pivot][i] == T{0})
+                return T{0};
+            if(pivot != i) {
+                std::swap(matrix.rows[pivot], matrix.rows[i]);
+                result = -result;
+            }
+            result *= matrix.rows[i][i];
+            for(auto j = i + 1; j < ROWS; ++j)
+                matrix.rows[j] -= matrix.rows[i] *
+                    (matrix.rows[j][i] / matrix.rows[i][i]);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Compute inverse by Gauss-Jordan elimination.
+     * @return Inverse matrix.
+     */
+    constexpr auto Inverse() const -> Matrix {
+        static_assert(R == C);
+        auto matrix = *this;
+        auto result = Identity();
+        for(std::size_t i = 0; i < ROWS; ++i) {
+            const auto pivot = matrix.Pivot(i);
+            if(matrix.rows[pivot][i] == T{0})
+                throw MatrixError("Matrix is singular");
+            std::swap(matrix.rows[pivot], matrix.rows[i]);
+            std::swap(result.rows[pivot], result.rows[i]);
+            const auto scale = T{1} / matrix.rows[i][i];
+            matrix.rows[i] *= scale;
+            result.rows[i] *= scale;
+            for(std::size_t j = 0; j < ROWS; ++j) {
+                if(j == i)
+                    continue;
+                const auto factor = matrix.rows[j][i];
+                matrix.rows[j] -= matrix.rows[i] * factor;
+                result.rows[j] -= result.rows[i] * factor;
+            }
+        }
+        return result;
+    }
+
+    /*! @brief * operator. */
+    template<std::integral auto K>
+    friend constexpr auto operator*(const Matrix& left,
+        const Matrix<T, C, K>& right) noexcept -> Matrix<T, R, K> {
+        Matrix<T, R, K> result;
+        for(std::size_t i = 0; i < ROWS; ++i) {
+            auto row = right[0] * left.rows[i][0];
+            for(std::size_t k = 1; k < COLUMNS; ++k)
+                row += right[k] * left.rows[i][k];
+            result[i] = row;
+        }
+        return result;
+    }
+
+    /*! @brief * operator. */
+    friend constexpr auto operator*(const Matrix& matrix,
+        const Vector<T, C>& vector) noexcept -> Vector<T, R> {
+        Vector<T, R> result;
+        for(std::size_t i = 0; i < ROWS; ++i)
+            result[i] = matrix.rows[i].Dot(vector);
+        return result;
+    }
+
+    /*! @brief Output stream << operator. */
+    friend std::ostream& operator<<(std::ostream& out, const Matrix& matrix) {
+        for(const auto& row : matrix.rows)
+            out << row << '\n';
+        return out;
+    }
+
+private:
+    /**
+     * @brief Find row with largest absolute value in column at or below
+     * diagonal.
+     * @param column Column index.
+     */
+    constexpr auto Pivot(const std::size_t column) const noexcept
+        -> std::size_t {
+        auto pivot = column;
+        for(auto i = column + 1; i < ROWS; ++i)
+            if(Abs(rows[i][column]) > Abs(rows[pivot][column]))
+                pivot = i;
+        return pivot;
+    }
+};
+
+/**
+ * @brief Transform point by homogeneous matrix.
+ * @tparam T Type of elements.
+ * @param matrix Matrix.
+ * @param point Point.
+ * @return Transformed point after perspective division.
+ */
+template<Arithmetic T>
+constexpr auto TransformPoint(const Matrix<T, 4, 4>& matrix,
+    const Vector<T, 3>& point) noexcept -> Vector<T, 3> {
+    const auto result = matrix * Vector<T, 4>(point[0], point[1], point[2],
+        T{1});
+    if(result[3] == T{1})
+        return Vector<T, 3>(result[0], result[1], result[2]);
+    return Vector<T, 3>(result[0], result[1], result[2]) / result[3];
+}
+
+/**
+ * @brief Transform direction by homogeneous matrix, ignoring translation.
+ * @tparam T Type of elements.
+ * @param matrix Matrix.
+ * @param direction Direction.
+ * @return Transformed direction.
+ */
+template<Arithmetic T>
+constexpr auto TransformDirection(const Matrix<T, 4, 4>& matrix,
+    const Vector<T, 3>& direction) noexcept -> Vector<T, 3> {
+    const auto result = matrix * Vector<T, 4>(direction[0], direction[1],
+        direction[2], T{0});
+    return Vector<T, 3>(result[0], result[1], result[2]);
+}
+
+/**
+ * @brief Transform contiguous points by homogeneous matrix.
+ *
+ * Points are gathered into lane-parallel packets, so one pass transforms as
+ * many points at once as fit SIMD register. Input and output may alias.
+ * @tparam T Type of elements.
+ * @tparam W Number of lanes.
+ * @param matrix Matrix.
+ * @param input Points.
+ * @param output Transformed points after perspective division.
+ */
+template<Arithmetic T, std::size_t W = LANES<T>>
+inline void Transform(const Matrix<T, 4, 4>& matrix,
+    const std::span<const Vector<T, 3>> input,
+    const std::span<Vector<T, 3>> output) noexcept {
+    const auto count = std::min(input.size(), output.size());
+    auto i = std::size_t{0};
+    for(; i + W <= count; i += W) {
+        VectorPack<T, 3, W> points;
+        for(std::size_t lane = 0; lane < W; ++lane)
+            points.Set(lane, input[i + lane]);
+        std::array<Pack<T, W>, 4> result;
+        for(std::size_t row = 0; row < 4; ++row)
+            result[row] = points[0] * Pack<T, W>(matrix[row][0]) +
+                points[1] * Pack<T, W>(matrix[row][1]) +
+                points[2] * Pack<T, W>(matrix[row][2]) +
+                Pack<T, W>(matrix[row][3]);
+        const auto w = Pack<T, W>(T{1}) / result[3];
+        const auto affine = result[3] == Pack<T, W>(T{1});
+        const auto transformed = Select(affine,
+            VectorPack<T, 3, W>(result[0], result[1], result[2]),
+            VectorPack<T, 3, W>(result[0], result[1], result[2]) * w);
+        for(std::size_t lane = 0; lane < W; ++lane)
+            output[i + lane] = transformed.Get(lane);
+    }
+    for(; i < count; ++i)
+        output[i] = TransformPoint(matrix, input[i]);
+}
+
+/**
+ * @brief Transform contiguous points by homogeneous matrix in place.
+ * @tparam T Type of elements.
+ * @param matrix Matrix.
+ * @param points Points.
+ */
+template<Arithmetic T>
+inline void Transform(const Matrix<T, 4, 4>& matrix,
+    const std::span<Vector<T, 3>> points) noexcept {
+    Transform(matrix, std::span<const Vector<T, 3>>(points), points);
+}
+
+/**
+ * @brief Build orthonormal camera basis.
+ * @tparam T Type of elements.
+ * @param eye Position of eye.
+ * @param center Point eye looks at.
+ * @param up Up direction.
+ * @return Rows of right, up and backward unit vectors.
+ */
+template<Arithmetic T>
+constexpr auto LookAtBasis(const Vector<T, 3>& eye, const Vector<T, 3>& center,
+    const Vector<T, 3>& up) -> Matrix<T, 3, 3> {
+    const auto w = Normalize(eye - center);
+    const auto u = Cross(up, w).Normalize();
+    const auto v = Cross(w, u);
+    return Matrix<T, 3, 3>(u, v, w);
+}
+
+/**
+ * @brief Build view matrix.
+ * @tparam T Type of elements.
+ * @param eye Position of eye.
+ * @param center Point eye looks at.
+ * @param up Up direction.
+ * @return Matrix that transforms world space into view space.
+ */
+template<Arithmetic T>
+constexpr auto LookAt(const Vector<T, 3>& eye, const Vector<T, 3>& center,
+    const Vector<T, 3>& up) -> Matrix<T, 4, 4> {
+    const auto basis = LookAtBasis(eye, center, up);
+    auto result = Matrix<T, 4, 4>::Identity();
+    for(std::size_t i = 0; i < 3; ++i) {
+        for(std::size_t j = 0; j < 3; ++j)
+            result[i][j] = basis[i][j];
+        result[i][3] = -basis[i].Dot(eye);
+    }
+    return result;
+}
+
+/**
+ * @brief Build perspective projection matrix.
+ * @tparam T Type of elements.
+ * @param vertical_fov Vertical field of view in radians.
+ * @param aspect_ratio Width to height ratio.
+ * @param near Distance of near plane.
+ * @param far Distance of far plane.
+ * @return Matrix that transforms view space into clip space.
+ */
+template<Arithmetic T>
+inline auto Perspective(const T vertical_fov, const T aspect_ratio,
+    const T near, const T far) -> Matrix<T, 4, 4> {
+    const auto focal = T{1} / std::tan(vertical_fov / T{2});
+    auto result = Matrix<T, 4, 4>::Zero();
+    result[0][0] = focal / aspect_ratio;
+    result[1][1] = focal;
+    result[2][2] = (far + near) / (near - far);
+    result[2][3] = T{2} * far * near / (near - far);
+    result[3][2] = T{-1};
+    return result;
+}
+
+/**
+ * @brief Build viewport matrix, depth is left unchanged.
+ * @tparam T Type of elements.
+ * @param x Left edge of viewport.
+ * @param y Bottom edge of viewport.
+ * @param width Width of viewport.
+ * @param height Height of viewport.
+ * @return Matrix that maps normalized device coordinates to pixels.
+ */
+template<Arithmetic T>
+constexpr auto Viewport(const T x, const T y, const T width, const T height)
+    noexcept -> Matrix<T, 4, 4> {
+    auto result = Matrix<T, 4, 4>::Identity();
+    result[0][0] = width / T{2};
+    result[0][3] = x + width / T{2};
+    result[1][1] = height / T{2};
+    result[1][3] = y + height / T{2};
+    return result;
+}
+
+} // namespace math
@@ -0,0 +1,292 @@
+module;
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <limits>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+export module Storage;
+
+import Vector;
+
+export namespace math {
+
+/**
+ * @brief Convert float to IEEE 754 half-precision bits.
+ *
+ * Rounds to nearest even, overflows to infinity and keeps NaN a NaN.
+ * @param value Value.
+ */
+constexpr auto ToHalf(const float value) noexcept -> std::uint16_t {
+#if defined(__F16C__)
+    if !consteval {
+        return static_cast<std::uint16_t>(_cvtss_sh(value, 0));
+    }
+#endif
+    const auto bits = std::bit_cast<std::uint32_t>(value);
+    const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+    auto magnitude = bits & 0x7fffffffu;
+    if(magnitude > 0x7f800000u)
+        return sign | 0x7e00u;
+    if(magnitude >= 0x477ff000u)
+        return sign | 0x7c00u;
+    if(magnitude < 0x38800000u) {
+        const auto shifted = std::bit_cast<float>(magnitude) + 0.5f;
+        return sign | static_cast<std::uint16_t>(
+            std::bit_cast<std::uint32_t>(shifted) - 0x3f000000u);
+    }
+    magnitude += 0xc8000fffu + ((magnitude >> 13) & 1u);
+    return sign | static_cast<std::uint16_t>(magnitude >> 13);
+}
+
+/**
+ * @brief Convert IEEE 754 half-precision bits to float, exactly.
+ * @param half Half-precision bits.
+ */
+constexpr auto FromHalf(const std::uint16_t half) noexcept -> float {
+#if defined(__F16C__)
+    if !consteval {
+        return _cvtsh_ss(half);
+    }
+#endif
+    const auto sign = static_cast<std::uint32_t>(half & 0x8000u) << 16;
+    const auto exponent = (half >> 10) & 0x1fu;
+    const auto mantissa = static_cast<std::uint32_t>(half & 0x3ffu);
+    if(exponent == 0)
+        return std::bit_cast<float>(sign | std::bit_cast<std::uint32_t>(
+            static_cast<float>(mantissa) * 5.96046448e-8f));
+    if(exponent == 0x1fu)
+        return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+    return std::bit_cast<float>(sign | ((exponent + 112u) << 23) |
+        (mantissa << 13));
+}
+
+/**
+ * @brief Convert float in [-1, 1] to normalized 16-bit integer, rounding to
+ * nearest, clamping values outside and taking NaN, such as of normalized
+ * zero vector, to zero.
+ * @param value Value.
+ */
+constexpr auto ToSnorm16(const float value) noexcept -> std::int16_t {
+    const auto clamped = value >= -1.0f ? (value <= 1.0f ? value : 1.0f) :
+        (value < -1.0f ? -1.0f : 0.0f);
+    return static_cast<std::int16_t>(clamped * 32767.0f +
+        (clamped < 0.0f ? -0.5f : 0.5f));
+}
+
+/**
+ * @brief Convert normalized 16-bit integer to float in [-1, 1].
+ * @param snorm Normalized integer.
+ */
+constexpr auto FromSnorm16(const std::int16_t snorm) noexcept -> float {
+    const auto value = static_cast<float>(snorm) / 32767.0f;
+    return value < -1.0f ? -1.0f : value;
+}
+
+/**
+ * @brief Vector padded to power-of-two number of elements and aligned to its
+ * size, so one aligned SIMD load fetches it whole.
+ *
+ * Three floats take sixteen bytes instead of twelve.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ */
+template<Arithmetic T, std::integral auto N>
+class PaddedVector {
+public:
+    /*! @brief Number of elements including padding. */
+    static constexpr std::size_t WIDTH = std::bit_ceil(
+        static_cast<std::size_t>(N));
+
+private:
+    /*! @brief Elements, padding is zero. */
+    alignas(WIDTH * sizeof(T)) std::array<T, WIDTH> elements{};
+
+public:
+    /*! @brief Default constructor, zero vector. */
+    constexpr PaddedVector() noexcept = default;
+
+    /*! @brief Constructor that stores vector. */
+    explicit constexpr PaddedVector(const Vector<T, N>& vector) noexcept {
+        Store(vector);
+    }
+
+    /*! @brief Load vector. */
+    constexpr auto Load() const noexcept -> Vector<T, N> {
+        Vector<T, N> vector;
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            vector[i] = elements[i];
+        return vector;
+    }
+
+    /*! @brief Store vector, keeping padding zero. */
+    constexpr void Store(const Vector<T, N>& vector) noexcept {
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            elements[i] = vector[i];
+    }
+
+    /*! @brief Get aligned pointer to elements including padding. */
+    constexpr auto Data() const noexcept -> const T* {
+        return elements.data();
+    }
+
+    /*! @brief Conversion to vector. */
+    constexpr operator Vector<T, N>() const noexcept { return Load(); }
+};
+
+/**
+ * @brief Vector stored tightly packed, with alignment of its elements and no
+ * padding whatever Vector itself might use.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ */
+template<Arithmetic T, std::integral auto N>
+class PackedVector {
+private:
+    /*! @brief Elements. */
+    std::array<T, N> elements{};
+
+public:
+    /*! @brief Default constructor, zero vector. */
+    constexpr PackedVector() noexcept = default;
+
+    /*! @brief Constructor that stores vector. */
+    explicit constexpr PackedVector(const Vector<T, N>& vector) noexcept {
+        Store(vector);
+    }
+
+    /*! @brief Load vector. */
+    constexpr auto Load() const noexcept -> Vector<T, N> {
+        Vector<T, N> vector;
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            vector[i] = elements[i];
+        return vector;
+    }
+
+    /*! @brief Store vector. */
+    constexpr void Store(const Vector<T, N>& vector) noexcept {
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            elements[i] = vector[i];
+    }
+
+    /*! @brief Conversion to vector. */
+    constexpr operator Vector<T, N>() const noexcept { return Load(); }
+};
+
+/**
+ * @brief Float vector stored in half precision, converted on load.
+ *
+ * Halves memory of large buffers such as colors, at relative precision of
+ * about 5e-4 and range up to 65504.
+ * @tparam N Number of elements.
+ */
+template<std::integral auto N>
+class HalfVector {
+private:
+    /*! @brief Half-precision bits of elements. */
+    std::array<std::uint16_t, N> elements{};
+
+public:
+    /*! @brief Default constructor, zero vector. */
+    constexpr HalfVector() noexcept = default;
+
+    /*! @brief Constructor that stores vector. */
+    explicit constexpr HalfVector(const Vector<float, N>& vector) noexcept {
+        Store(vector);
+    }
+
+    /*! @brief Load vector. */
+    constexpr auto Load() const noexcept -> Vector<float, N> {
+        Vector<float, N> vector;
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            vector[i] = FromHalf(elements[i]);
+        return vector;
+    }
+
+    /*! @brief Store vector, rounding to nearest half. */
+    constexpr void Store(const Vector<float, N>& vector) noexcept {
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            elements[i] = ToHalf(vector[i]);
+    }
+
+    /*! @brief Conversion to vector. */
+    constexpr operator Vector<float, N>() const noexcept { return Load(); }
+};
+
+/**
+ * @brief Float vector with elements in [-1, 1] stored as normalized 16-bit
+ * integers, converted on load.
+ *
+ * Suits unit vectors such as normals, with uniform absolute precision of
+ * about 3e-5.
+ * @tparam N Number of elements.
+ */
+template<std::integral auto N>
+class Snorm16Vector {
+private:
+    /*! @brief Normalized integers of elements. */
+    std::array<std::int16_t, N> elements{};
+
+public:
+    /*! @brief Default constructor, zero vector. */
+    constexpr Snorm16Vector() noexcept = default;
+
+    /*! @brief Constructor that stores vector. */
+    explicit constexpr Snorm16Vector(const Vector<float, N>& vector) noexcept {
+        Store(vector);
+    }
+
+    /*! @brief Load vector. */
+    constexpr auto Load() const noexcept -> Vector<float, N> {
+        Vector<float, N> vector;
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            vector[i] = FromSnorm16(elements[i]);
+        return vector;
+    }
+
+    /*! @brief Store vector, clamping elements to [-1, 1]. */
+    constexpr void Store(const Vector<float, N>& vector) noexcept {
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            elements[i] = ToSnorm16(vector[i]);
+    }
+
+    /*! @brief Conversion to vector. */
+    constexpr operator Vector<float, N>() const noexcept { return Load(); }
+};
+
+} // namespace math
+
+namespace math::detail::checks {
+
+static_assert(sizeof(PaddedVector<float, 3>) == 16);
+static_assert(alignof(PaddedVector<float, 3>) == 16);
+static_assert(sizeof(PackedVector<float, 3>) == 12);
+static_assert(sizeof(HalfVector<3>) == 6 && sizeof(Snorm16Vector<3>) == 6);
+
+static_assert(ToHalf(1.0f) == 0x3c00u && ToHalf(-2.0f) == 0xc000u);
+static_assert(ToHalf(65504.0f) == 0x7bffu && ToHalf(1e6f) == 0x7c00u);
+static_assert(ToHalf(1.0f + 0x1p-11f) == 0x3c00u);
+static_assert(ToHalf(1.0f + 0x1p-10f + 0x1p-11f) == 0x3c02u);
+static_assert(ToHalf(0x1p-24f) == 0x0001u && ToHalf(0.0f) == 0x0000u);
+static_assert(FromHalf(0x3c00u) == 1.0f && FromHalf(0x0001u) == 0x1p-24f);
+static_assert(FromHalf(0x7bffu) == 65504.0f && FromHalf(0x8000u) == -0.0f);
+static_assert(FromHalf(ToHalf(0.333251953125f)) == 0.333251953125f);
+
+static_assert(ToSnorm16(1.0f) == 32767 && ToSnorm16(-1.0f) == -32767);
+static_assert(ToSnorm16(2.0f) == 32767 && FromSnorm16(-32768) == -1.0f);
+static_assert(FromSnorm16(ToSnorm16(0.0f)) == 0.0f);
+static_assert(ToSnorm16(std::numeric_limits<float>::quiet_NaN()) == 0);
+
+static_assert(PaddedVector<float, 3>(Vector<float, 3>{1.0f, 2.0f, 3.0f})
+    .Load() == Vector<float, 3>{1.0f, 2.0f, 3.0f});
+static_assert(HalfVector<3>(Vector<float, 3>{0.5f, -4.0f, 1024.0f})
+    .Load() == Vector<float, 3>{0.5f, -4.0f, 1024.0f});
+
+} // namespace math::detail::checks
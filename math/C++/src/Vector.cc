@@ -1,17 +1,255 @@
 module;
 
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <concepts>
-#include <execution>
+#include <functional>
 #include <iomanip>
 #include <iostream>
-#include <numeric>
+#include <limits>
 #include <type_traits>
+#include <utility>
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE__)
+#include <immintrin.h>
+#endif
 
 export module Vector;
 
+namespace math::detail {
+
+/**
+ * @brief Element-wise kernels of vector, sequential generic fallback.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ */
+template<typename T, std::size_t N>
+struct Kernels {
+    /*! @brief Array of elements. */
+    using Array = std::array<T, N>;
+
+    /*! @brief Element-wise sum. */
+    static constexpr auto Add(const Array& left, const Array& right) noexcept
+        -> Array {
+        Array result;
+        for(std::size_t i = 0; i < N; ++i)
+            result[i] = left[i] + right[i];
+        return result;
+    }
+
+    /*! @brief Element-wise difference. */
+    static constexpr auto Subtract(const Array& left, const Array& right)
+        noexcept -> Array {
+        Array result;
+        for(std::size_t i = 0; i < N; ++i)
+            result[i] = left[i] - right[i];
+        return result;
+    }
+
+    /*! @brief Element-wise product. */
+    static constexpr auto Multiply(const Array& left, const Array& right)
+        noexcept -> Array {
+        Array result;
+        for(std::size_t i = 0; i < N; ++i)
+            result[i] = left[i] * right[i];
+        return result;
+    }
+
+    /*! @brief Product with scalar. */
+    static constexpr auto Scale(const Array& array, const T number) noexcept
+        -> Array {
+        Array result;
+        for(std::size_t i = 0; i < N; ++i)
+            result[i] = array[i] * number;
+        return result;
+    }
+
+    /*! @brief Element-wise negation. */
+    static constexpr auto Negate(const Array& array) noexcept -> Array {
+        Array result;
+        for(std::size_t i = 0; i < N; ++i)
+            result[i] = -array[i];
+        return result;
+    }
+
+    /*! @brief Sum of element-wise products. */
+    static constexpr auto Dot(const Array& left, const Array& right) noexcept
+        -> T {
+        T result{0};
+        for(std::size_t i = 0; i < N; ++i)
+            result += left[i] * right[i];
+        return result;
+    }
+};
+
+/**
+ * @brief Element-wise kernels of vector, fully unrolled at compile time.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ */
+template<typename T, std::size_t N>
+struct UnrolledKernels {
+    /*! @brief Array of elements. */
+    using Array = std::array<T, N>;
+
+    /**
+     * @brief Apply binary function to each pair of elements.
+     * @param left First array.
+     * @param right Second array.
+     * @param function Function.
+     */
+    template<typename F>
+    static constexpr auto Apply(const Array& left, const Array& right,
+        F function) noexcept -> Array {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return Array{function(left[I], right[I])...};
+        }(std::make_index_sequence<N>{});
+    }
+
+    /*! @brief Element-wise sum. */
+    static constexpr auto Add(const Array& left, const Array& right) noexcept
+        -> Array {
+        return Apply(left, right, std::plus<>{});
+    }
+
+    /*! @brief Element-wise difference. */
+    static constexpr auto Subtract(const Array& left, const Array& right)
+        noexcept -> Array {
+        return Apply(left, right, std::minus<>{});
+    }
+
+    /*! @brief Element-wise product. */
+    static constexpr auto Multiply(const Array& left, const Array& right)
+        noexcept -> Array {
+        return Apply(left, right, std::multiplies<>{});
+    }
+
+    /*! @brief Product with scalar. */
+    static constexpr auto Scale(const Array& array, const T number) noexcept
+        -> Array {
+        return Apply(array, array,
+            [number](const T value, const T) { return value * number; });
+    }
+
+    /*! @brief Element-wise negation. */
+    static constexpr auto Negate(const Array& array) noexcept -> Array {
+        return Apply(array, array, [](const T value, const T) {
+            return -value; });
+    }
+
+    /*! @brief Sum of element-wise products. */
+    static constexpr auto Dot(const Array& left, const Array& right) noexcept
+        -> T {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return (T{0} + ... + (left[I] * right[I]));
+        }(std::make_index_sequence<N>{});
+    }
+};
+
+/*! @brief Kernels of 2D float vector. */
+template<>
+struct Kernels<float, 2> : UnrolledKernels<float, 2> {};
+
+/*! @brief Kernels of 3D float vector. */
+template<>
+struct Kernels<float, 3> : UnrolledKernels<float, 3> {};
+
+#if defined(__SSE__)
+/*! @brief Kernels of 4D float vector, one SSE register wide. */
+template<>
+struct Kernels<float, 4> : UnrolledKernels<float, 4> {
+    /*! @brief Array of elements. */
+    using Array = std::array<float, 4>;
+
+    /*! @brief Load array to register. */
+    static inline auto Load(const Array& array) noexcept -> __m128 {
+        return _mm_loadu_ps(array.data());
+    }
+
+    /*! @brief Store register to array. */
+    static inline auto Store(const __m128 value) noexcept -> Array {
+        Array result;
+        _mm_storeu_ps(result.data(), value);
+        return result;
+    }
+
+    /*! @brief Element-wise sum. */
+    static constexpr auto Add(const Array& left, const Array& right) noexcept
+        -> Array {
+        if consteval {
+            return UnrolledKernels::Add(left, right);
+        } else {
+            return Store(_mm_add_ps(Load(left), Load(right)));
+        }
+    }
+
+    /*! @brief Element-wise difference. */
+    static constexpr auto Subtract(const Array& left, const Array& right)
+        noexcept -> Array {
+        if consteval {
+            return UnrolledKernels::Subtract(left, right);
+        } else {
+            return Store(_mm_sub_ps(Load(left), Load(right)));
+        }
+    }
+
+    /*! @brief Element-wise product. */
+    static constexpr auto Multiply(const Array& left, const Array& right)
+        noexcept -> Array {
+        if consteval {
+            return UnrolledKernels::Multiply(left, right);
+        } else {
+            return Store(_mm_mul_ps(Load(left), Load(right)));
+        }
+    }
+
+    /*! @brief Product with scalar. */
+    static constexpr auto Scale(const Array& array, const float number) noexcept
+        -> Array {
+        if consteval {
+            return UnrolledKernels::Scale(array, number);
+        } else {
+            return Store(_mm_mul_ps(Load(array), _mm_set1_ps(number)));
+        }
+    }
+
+    /*! @brief Element-wise negation. */
+    static constexpr auto Negate(const Array& array) noexcept -> Array {
+        if consteval {
+            return UnrolledKernels::Negate(array);
+        } else {
+            return Store(_mm_xor_ps(Load(array), _mm_set1_ps(-0.0f)));
+        }
+    }
+
+    /*! @brief Sum of element-wise products. */
+    static constexpr auto Dot(const Array& left, const Array& right) noexcept
+        -> float {
+        if consteval {
+            return UnrolledKernels::Dot(left, right);
+        } else {
+            const auto product = _mm_mul_ps(Load(left), Load(right));
+            const auto high = _mm_movehl_ps(product, product);
+            const auto pairs = _mm_add_ps(product, high);
+            const auto sum = _mm_add_ss(pairs,
+                _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1)));
+            return _mm_cvtss_f32(sum);
+        }
+    }
+};
+#else
+/*! @brief Kernels of 4D float vector. */
+template<>
+struct Kernels<float, 4> : UnrolledKernels<float, 4> {};
+#endif
+
+} // namespace math::detail
+
 export namespace math {
 
 /**
@@ -21,6 +259,170 @@ export namespace math {
 template<typename T>
 concept Arithmetic = std::is_arithmetic_v<T>;
 
+/**
+ * @brief Compute absolute value, usable in constant expressions.
+ * @tparam T Arithmetic type.
+ * @param value Value.
+ */
+template<Arithmetic T>
+constexpr auto Abs(const T value) noexcept -> T {
+    return value < T{0} ? -value : value;
+}
+
+/**
+ * @brief Compute square root, usable in constant expressions.
+ *
+ * Constant evaluation runs Newton's iteration from above until it stops
+ * decreasing, which lands within one unit in the last place of exact result.
+ * Runtime evaluation calls std::sqrt.
+ * @tparam T Arithmetic type.
+ * @param value Value.
+ */
+template<Arithmetic T>
+constexpr auto Sqrt(const T value) noexcept {
+    if consteval {
+        using F = std::conditional_t<std::is_floating_point_v<T>, T, double>;
+        const auto number = static_cast<F>(value);
+        if(number < F{0})
+            return std::numeric_limits<F>::quiet_NaN();
+        if(!(number > F{0}) || number == std::numeric_limits<F>::infinity())
+            return number;
+        auto current = number > F{1} ? number : F{1};
+        while(true) {
+            const auto next = (current + number / current) / F{2};
+            if(!(next < current))
+                return current;
+            current = next;
+        }
+    } else {
+        return std::sqrt(value);
+    }
+}
+
+/**
+ * @brief Pick one of two values without branch.
+ *
+ * Floats and doubles are blended through bit masks, which compilers turn
+ * into vector and-not-or sequences instead of per-lane jumps.
+ * @tparam T Arithmetic type.
+ * @param condition Condition.
+ * @param left Value if condition holds.
+ * @param right Value otherwise.
+ */
+template<Arithmetic T>
+constexpr auto Blend(const bool condition, const T left,
+    const T right) noexcept -> T {
+    if constexpr(std::same_as<T, float> || std::same_as<T, double>) {
+        using Bits = std::conditional_t<sizeof(T) == 4, std::uint32_t,
+            std::uint64_t>;
+        const auto mask = Bits{0} - static_cast<Bits>(condition);
+        return std::bit_cast<T>((std::bit_cast<Bits>(left) & mask) |
+            (std::bit_cast<Bits>(right) & ~mask));
+    } else {
+        return condition ? left : right;
+    }
+}
+
+/*! @brief Expression templates that fuse vector arithmetic chains. */
+namespace expr {
+
+/*! @brief Base of expression nodes. */
+struct Node {};
+
+/**
+ * @brief Expression concept.
+ * @tparam E Type to check.
+ */
+template<typename E>
+concept Expression = std::is_base_of_v<Node, E>;
+
+/**
+ * @brief Element-wise binary operation node.
+ * @tparam L Left operand expression.
+ * @tparam R Right operand expression.
+ * @tparam F Operation.
+ */
+template<Expression L, Expression R, typename F>
+    requires (L::SIZE == R::SIZE)
+class Binary : public Node {
+private:
+    /*! @brief Left operand. */
+    L left;
+    /*! @brief Right operand. */
+    R right;
+
+public:
+    /*! @brief Type of elements. */
+    using Element = typename L::Element;
+    /*! @brief Number of elements. */
+    static constexpr auto SIZE = L::SIZE;
+
+    /*! @brief Constructor that accepts operands. */
+    constexpr Binary(const L& left, const R& right) noexcept :
+        left{left}, right{right} {}
+
+    /*! @brief Evaluate element. */
+    constexpr auto operator[](const std::size_t index) const noexcept {
+        return F{}(left[index], right[index]);
+    }
+};
+
+/**
+ * @brief Product of expression and scalar node.
+ * @tparam E Operand expression.
+ */
+template<Expression E>
+class Scaled : public Node {
+private:
+    /*! @brief Operand. */
+    E operand;
+    /*! @brief Multiplier. */
+    typename E::Element multiplier;
+
+public:
+    /*! @brief Type of elements. */
+    using Element = typename E::Element;
+    /*! @brief Number of elements. */
+    static constexpr auto SIZE = E::SIZE;
+
+    /*! @brief Constructor that accepts operand and multiplier. */
+    constexpr Scaled(const E& operand, const Element multiplier) noexcept :
+        operand{operand}, multiplier{multiplier} {}
+
+    /*! @brief Evaluate element. */
+    constexpr auto operator[](const std::size_t index) const noexcept {
+        return operand[index] * multiplier;
+    }
+};
+
+/**
+ * @brief Negation node.
+ * @tparam E Operand expression.
+ */
+template<Expression E>
+class Negated : public Node {
+private:
+    /*! @brief Operand. */
+    E operand;
+
+public:
+    /*! @brief Type of elements. */
+    using Element = typename E::Element;
+    /*! @brief Number of elements. */
+    static constexpr auto SIZE = E::SIZE;
+
+    /*! @brief Constructor that accepts operand. */
+    constexpr explicit Negated(const E& operand) noexcept :
+        operand{operand} {}
+
+    /*! @brief Evaluate element. */
+    constexpr auto operator[](const std::size_t index) const noexcept {
+        return -operand[index];
+    }
+};
+
+} // namespace expr
+
 /**
  * @brief Vector.
  * @tparam T Arithmetic type of elements.
@@ -30,91 +432,112 @@ template<Arithmetic T, std::integral auto N>
     requires (N > 0)
 class Vector {
 private:
+    /*! @brief Element-wise kernels. */
+    using Kernels = detail::Kernels<T, static_cast<std::size_t>(N)>;
+
     /*! @brief Elements. */
     std::array<T, N> elements;
 public:
     /*! @brief Default constructor. */
-    Vector() noexcept = default;
+    constexpr Vector() noexcept = default;
 
     /*! @brief Copy constructor. */
-    Vector(const Vector&) noexcept = default;
+    constexpr Vector(const Vector&) noexcept = default;
 
     /*! @brief Move constructor. */
-    Vector(Vector&&) noexcept = default;
+    constexpr Vector(Vector&&) noexcept = default;
 
     /*! @brief Destructor. */
-    ~Vector() noexcept = default;
+    constexpr ~Vector() noexcept = default;
 
     /*! @brief Copy constructor that accepts array. */
-    Vector(const std::array<T, N>& array) noexcept : elements{array} {}
+    constexpr Vector(const std::array<T, N>& array) noexcept :
+        elements{array} {}
 
     /*! @brief Move constructor that accepts array. */
-    Vector(std::array<T, N>&& array) noexcept : elements{std::move(array)} {}
+    constexpr Vector(std::array<T, N>&& array) noexcept :
+        elements{std::move(array)} {}
 
     /**
      * @brief Constructor that accepts variadic number of arguments.
      * @param arguments Arguments.
      */
     template<typename... Args>
-        requires (sizeof...(Args) == N)
-    Vector(const Args... arguments) noexcept :
+        requires (sizeof...(Args) == N && (!expr::Expression<Args> && ...))
+    constexpr Vector(const Args... arguments) noexcept :
         elements{static_cast<T>(arguments)...} {}
 
+    /**
+     * @brief Constructor that evaluates expression in single loop.
+     * @param expression Expression.
+     */
+    template<expr::Expression E>
+        requires (E::SIZE == static_cast<std::size_t>(N))
+    constexpr Vector(const E& expression) noexcept : elements{} {
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            elements[i] = static_cast<T>(expression[i]);
+    }
+
     /*! @brief Copy assignment operator. */
-    inline Vector& operator=(const Vector&) noexcept = default;
+    constexpr Vector& operator=(const Vector&) noexcept = default;
 
     /*! @brief Move assignment operator. */
-    inline Vector& operator=(Vector&&) noexcept = default;
+    constexpr Vector& operator=(Vector&&) noexcept = default;
+
+    /*! @brief Assignment operator that evaluates expression. */
+    template<expr::Expression E>
+        requires (E::SIZE == static_cast<std::size_t>(N))
+    constexpr Vector& operator=(const E& expression) noexcept {
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            elements[i] = static_cast<T>(expression[i]);
+        return *this;
+    }
 
     /*! @brief Subscript operator. */
-    inline auto operator[](const std::integral auto index) const noexcept {
+    constexpr auto operator[](const std::integral auto index) const noexcept {
         return elements[index];
     }
 
     /*! @brief Subscript operator. */
-    inline auto& operator[](const std::integral auto index) noexcept {
+    constexpr auto& operator[](const std::integral auto index) noexcept {
         return elements[index];
     }
 
     /*! @brief Iterator wrapper. */
-    inline auto begin() const noexcept { return elements.begin(); }
+    constexpr auto begin() const noexcept { return elements.begin(); }
 
     /*! @brief Iterator wrapper. */
-    inline auto begin() noexcept { return elements.begin(); }
+    constexpr auto begin() noexcept { return elements.begin(); }
 
     /*! @brief Iterator wrapper. */
-    inline auto end() const noexcept { return elements.end(); }
+    constexpr auto end() const noexcept { return elements.end(); }
 
     /*! @brief Iterator wrapper. */
-    inline auto end() noexcept { return elements.end(); }
+    constexpr auto end() noexcept { return elements.end(); }
 
     /*! @brief Compute length. */
-    inline auto Length() const -> T {
-        return std::sqrt(Length2());
+    constexpr auto Length() const noexcept -> T {
+        return Sqrt(Length2());
     }
 
     /*! @brief Compute squared length. */
-    inline auto Length2() const -> T {
-        return std::transform_reduce(std::execution::par_unseq,
-            this->begin(), this->end(), T{0},
-            std::plus<>{}, [](const auto value) { return value * value; });
+    constexpr auto Length2() const noexcept -> T {
+        return Kernels::Dot(elements, elements);
     }
 
     /**
      * @brief Compute dot product with another vector.
      * @param vector Vector.
      */
-    inline auto Dot(const Vector& vector) const -> T {
-        return std::transform_reduce(std::execution::par_unseq,
-            this->begin(), this->end(), vector.begin(), T{0},
-            std::plus<>{}, std::multiplies<>{});
+    constexpr auto Dot(const Vector& vector) const noexcept -> T {
+        return Kernels::Dot(elements, vector.elements);
     }
 
     /**
      * @brief Compute cross product with another vector.
      * @param vector Vector.
      */
-    inline auto Cross(const Vector& vector) const noexcept -> Vector {
+    constexpr auto Cross(const Vector& vector) const noexcept -> Vector {
         static_assert(N == 3);
         return Vector(elements[1] * vector[2] - elements[2] * vector[1],
                       elements[2] * vector[0] - elements[0] * vector[2],
@@ -125,14 +548,14 @@ public:
      * @brief Normalize.
      * @return Normalized vector.
      */
-    inline auto Normalize() const -> Vector { return *this / Length(); }
+    constexpr auto Normalize() const -> Vector { return *this / Length(); }
 
     /**
      * @brief Reflect.
      * @param normal Normal vector.
      * @return Reflected vector.
      */
-    inline auto Reflect(const Vector& normal) const -> Vector {
+    constexpr auto Reflect(const Vector& normal) const -> Vector {
         static_assert(N == 3);
         return *this - T{2} * Dot(normal) * normal;
     }
@@ -143,120 +566,99 @@ public:
      * @param ratio Refraction ratio.
      * @return Refracted vector.
      */
-    inline auto Refract(const Vector& normal, const T ratio) const -> Vector {
+    constexpr auto Refract(const Vector& normal, const T ratio) const
+        -> Vector {
         static_assert(N == 3);
         const auto cos_theta = std::min((-*this).Dot(normal), T{1});
         const auto perpendicular = ratio * (*this + cos_theta * normal);
         const auto parallel =
-            -std::sqrt(std::abs(T{1} - perpendicular.Length2())) * normal;
+            -Sqrt(Abs(T{1} - perpendicular.Length2())) * normal;
         return perpendicular + parallel;
     }
 
     /*! @brief Unary - operator. */
-    inline Vector operator-() const {
-        Vector result;
-        std::transform(std::execution::par_unseq,
-            this->begin(), this->end(), result.begin(),
-            [](const auto value) { return -value; });
-        return result;
+    constexpr Vector operator-() const noexcept {
+        return Kernels::Negate(elements);
     }
 
     /*! @brief += operator. */
-    inline Vector& operator+=(const Vector& vector) {
-        std::transform(std::execution::par_unseq,
-            vector.begin(), vector.end(), this->begin(), this->begin(),
-            std::plus<>{});
+    constexpr Vector& operator+=(const Vector& vector) noexcept {
+        elements = Kernels::Add(elements, vector.elements);
         return *this;
     }
 
     /*! @brief -= operator. */
-    inline Vector& operator-=(const Vector& vector) {
-        std::transform(std::execution::par_unseq,
-            vector.begin(), vector.end(), this->begin(), this->begin(),
-            std::minus<>{});
+    constexpr Vector& operator-=(const Vector& vector) noexcept {
+        elements = Kernels::Subtract(elements, vector.elements);
         return *this;
     }
 
     /*! @brief *= operator. */
-    inline Vector& operator*=(const Vector& vector) {
-        std::transform(std::execution::par_unseq,
-            vector.begin(), vector.end(), this->begin(), this->begin(),
-            std::multiplies<>{});
+    constexpr Vector& operator*=(const Vector& vector) noexcept {
+        elements = Kernels::Multiply(elements, vector.elements);
         return *this;
     }
 
     /*! @brief *= operator. */
     template<Arithmetic U>
-    inline Vector& operator*=(const U number) {
-        const auto multiplier = static_cast<T>(number);
-        std::transform(std::execution::par_unseq,
-            this->begin(), this->end(), this->begin(),
-            [multiplier](const auto value) { return value * multiplier; });
+    constexpr Vector& operator*=(const U number) noexcept {
+        elements = Kernels::Scale(elements, static_cast<T>(number));
         return *this;
     }
 
     /*! @brief /= operator. */
     template<Arithmetic U>
-    inline Vector& operator/=(const U number) {
+    constexpr Vector& operator/=(const U number) noexcept {
         return *this *= T{1} / static_cast<T>(number);
     }
 
     /*! @brief + operator. */
-    friend inline Vector operator+(const Vector& left, const Vector& right) {
-        Vector result;
-        std::transform(std::execution::par_unseq,
-            left.begin(), left.end(), right.begin(), result.begin(),
-            std::plus<>{});
-        return result;
+    friend constexpr Vector operator+(const Vector& left, const Vector& right)
+        noexcept {
+        return Kernels::Add(left.elements, right.elements);
     }
 
     /*! @brief - operator. */
-    friend inline Vector operator-(const Vector& left, const Vector& right) {
-        Vector result;
-        std::transform(std::execution::par_unseq,
-            left.begin(), left.end(), right.begin(), result.begin(),
-            std::minus<>{});
-        return result;
+    friend constexpr Vector operator-(const Vector& left, const Vector& right)
+        noexcept {
+        return Kernels::Subtract(left.elements, right.elements);
     }
 
     /*! @brief * operator. */
-    friend inline Vector operator*(const Vector& left, const Vector& right) {
-        Vector result;
-        std::transform(std::execution::par_unseq,
-            left.begin(), left.end(), right.begin(), result.begin(),
-            std::multiplies<>{});
-        return result;
+    friend constexpr Vector operator*(const Vector& left, const Vector& right)
+        noexcept {
+        return Kernels::Multiply(left.elements, right.elements);
     }
 
     /*! @brief * operator. */
     template<Arithmetic U>
-    friend inline Vector operator*(const Vector& vector, const U number) {
-        const auto multiplier = static_cast<T>(number);
-        Vector result;
-        std::transform(std::execution::par_unseq,
-            vector.begin(), vector.end(), result.begin(),
-            [multiplier](const auto value) { return value * multiplier; });
-        return result;
+    friend constexpr Vector operator*(const Vector& vector, const U number)
+        noexcept {
+        return Kernels::Scale(vector.elements, static_cast<T>(number));
     }
 
     /*! @brief * operator. */
     template<Arithmetic U>
-    friend inline Vector operator*(const U number, const Vector& vector) {
+    friend constexpr Vector operator*(const U number, const Vector& vector) {
         return vector * number;
     }
 
     /*! @brief / operator. */
     template<Arithmetic U>
-    friend inline Vector operator/(const Vector& vector, const U number) {
+    friend constexpr Vector operator/(const Vector& vector, const U number) {
         return vector * (T{1} / static_cast<T>(number));
     }
 
     /*! @brief / operator. */
     template<Arithmetic U>
-    friend inline Vector operator/(const U number, const Vector& vector) {
+    friend constexpr Vector operator/(const U number, const Vector& vector) {
         return vector / number;
     }
 
+    /*! @brief == operator. */
+    friend constexpr bool operator==(const Vector&, const Vector&) noexcept =
+        default;
+
     /*! @brief Output stream << operator. */
     friend std::ostream& operator<<(std::ostream& out, const Vector& vector) {
         out << '[';
@@ -275,8 +677,8 @@ public:
  */
 template<Arithmetic T, std::integral auto N>
     requires (N > 0)
-inline auto Length(const Vector<T, N>& vector) -> T {
-    vector.Length();
+constexpr auto Length(const Vector<T, N>& vector) -> T {
+    return vector.Length();
 }
 
 /**
@@ -288,7 +690,7 @@ inline auto Length(const Vector<T, N>& vector) -> T {
  */
 template<Arithmetic T, std::integral auto N>
     requires (N > 0)
-inline auto Length2(const Vector<T, N>& vector) -> T {
+constexpr auto Length2(const Vector<T, N>& vector) noexcept -> T {
     return vector.Length2();
 }
 
@@ -302,7 +704,8 @@ inline auto Length2(const Vector<T, N>& vector) -> T {
  */
 template<Arithmetic T, std::integral auto N>
     requires (N > 0)
-inline auto Dot(const Vector<T, N>& left, const Vector<T, N>& right) -> T {
+constexpr auto Dot(const Vector<T, N>& left, const Vector<T, N>& right) noexcept
+    -> T {
     return left.Dot(right);
 }
 
@@ -316,7 +719,7 @@ inline auto Dot(const Vector<T, N>& left, const Vector<T, N>& right) -> T {
  */
 template<Arithmetic T, std::integral auto N>
     requires (N == 3)
-inline auto Cross(const Vector<T, N>& left, const Vector<T, N>& right)
+constexpr auto Cross(const Vector<T, N>& left, const Vector<T, N>& right)
     -> Vector<T, N> {
     return left.Cross(right);
 }
@@ -330,7 +733,7 @@ inline auto Cross(const Vector<T, N>& left, const Vector<T, N>& right)
  */
 template<Arithmetic T, std::integral auto N>
     requires (N > 0)
-inline auto Normalize(const Vector<T, N>& vector) -> Vector<T, N> {
+constexpr auto Normalize(const Vector<T, N>& vector) -> Vector<T, N> {
     return vector.Normalize();
 }
 
@@ -344,7 +747,7 @@ inline auto Normalize(const Vector<T, N>& vector) -> Vector<T, N> {
  */
 template<Arithmetic T, std::integral auto N>
     requires (N == 3)
-inline auto Reflect(const Vector<T, N>& vector, const Vector<T, N>& normal)
+constexpr auto Reflect(const Vector<T, N>& vector, const Vector<T, N>& normal)
     -> Vector<T, N> {
     return vector.Reflect(normal);
 }
@@ -360,9 +763,741 @@ inline auto Reflect(const Vector<T, N>& vector, const Vector<T, N>& normal)
  */
 template<Arithmetic T, std::integral auto N>
     requires (N == 3)
-inline auto Refract(const Vector<T, N>& vector, const Vector<T, N>& normal,
+constexpr auto Refract(const Vector<T, N>& vector, const Vector<T, N>& normal,
     const T ratio) -> Vector<T, N> {
     return vector.Refract(normal, ratio);
 }
 
+namespace expr {
+
+/**
+ * @brief Leaf node that refers to vector.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ */
+template<Arithmetic T, std::integral auto N>
+class Reference : public Node {
+private:
+    /*! @brief Referenced vector. */
+    const Vector<T, N>& vector;
+
+public:
+    /*! @brief Type of elements. */
+    using Element = T;
+    /*! @brief Number of elements. */
+    static constexpr auto SIZE = static_cast<std::size_t>(N);
+
+    /*! @brief Constructor that accepts vector. */
+    constexpr explicit Reference(const Vector<T, N>& vector) noexcept :
+        vector{vector} {}
+
+    /*! @brief Evaluate element. */
+    constexpr auto operator[](const std::size_t index) const noexcept -> T {
+        return vector[index];
+    }
+};
+
+/*! @brief Wrap operand that is already expression. */
+template<Expression E>
+constexpr auto Wrap(const E& expression) noexcept -> E { return expression; }
+
+/*! @brief Wrap vector operand into leaf node. */
+template<Arithmetic T, std::integral auto N>
+constexpr auto Wrap(const Vector<T, N>& vector) noexcept -> Reference<T, N> {
+    return Reference<T, N>(vector);
+}
+
+/**
+ * @brief Operand concept, expression or vector.
+ * @tparam E Type to check.
+ */
+template<typename E>
+concept Operand = requires(const E& operand) { Wrap(operand); };
+
+/**
+ * @brief Concept of operand pair of which at least one is expression.
+ * @tparam L Left operand type.
+ * @tparam R Right operand type.
+ */
+template<typename L, typename R>
+concept Operands = Operand<L> && Operand<R> &&
+    (Expression<L> || Expression<R>);
+
+/*! @brief + operator. */
+template<typename L, typename R>
+    requires Operands<L, R>
+constexpr auto operator+(const L& left, const R& right) noexcept {
+    return Binary<decltype(Wrap(left)), decltype(Wrap(right)), std::plus<>>(
+        Wrap(left), Wrap(right));
+}
+
+/*! @brief - operator. */
+template<typename L, typename R>
+    requires Operands<L, R>
+constexpr auto operator-(const L& left, const R& right) noexcept {
+    return Binary<decltype(Wrap(left)), decltype(Wrap(right)), std::minus<>>(
+        Wrap(left), Wrap(right));
+}
+
+/*! @brief * operator. */
+template<typename L, typename R>
+    requires Operands<L, R>
+constexpr auto operator*(const L& left, const R& right) noexcept {
+    return Binary<decltype(Wrap(left)), decltype(Wrap(right)),
+        std::multiplies<>>(Wrap(left), Wrap(right));
+}
+
+/*! @brief * operator. */
+template<Expression E, Arithmetic U>
+constexpr auto operator*(const E& expression, const U number) noexcept {
+    return Scaled<E>(expression, static_cast<typename E::Element>(number));
+}
+
+/*! @brief * operator. */
+template<Expression E, Arithmetic U>
+constexpr auto operator*(const U number, const E& expression) noexcept {
+    return expression * number;
+}
+
+/*! @brief / operator. */
+template<Expression E, Arithmetic U>
+constexpr auto operator/(const E& expression, const U number) noexcept {
+    using Element = typename E::Element;
+    return expression * (Element{1} / static_cast<Element>(number));
+}
+
+/*! @brief Unary - operator. */
+template<Expression E>
+constexpr auto operator-(const E& expression) noexcept {
+    return Negated<E>(expression);
+}
+
+} // namespace expr
+
+/**
+ * @brief Start lazily evaluated expression from vector.
+ *
+ * Arithmetic on the result builds expression nodes instead of vectors. The
+ * whole chain is evaluated in a single loop once it is assigned to a vector.
+ * Nodes refer to their vector operands, so an expression must be assigned
+ * within the full-expression that created it, never stored with auto.
+ * @tparam T Type of elements.
+ * @tparam N Number of elements.
+ * @param vector Vector.
+ * @return Leaf expression node.
+ */
+template<Arithmetic T, std::integral auto N>
+    requires (N > 0)
+constexpr auto Lazy(const Vector<T, N>& vector) noexcept
+    -> expr::Reference<T, N> {
+    return expr::Reference<T, N>(vector);
+}
+
+/*! @brief Width of widest SIMD register enabled at compile time in bytes. */
+#if defined(__AVX512F__)
+inline constexpr std::size_t REGISTER_BYTES = 64;
+#elif defined(__AVX2__) || defined(__AVX__)
+inline constexpr std::size_t REGISTER_BYTES = 32;
+#else
+inline constexpr std::size_t REGISTER_BYTES = 16;
+#endif
+
+/**
+ * @brief Number of lanes of given type that fill one SIMD register.
+ * @tparam T Arithmetic type of lanes.
+ */
+template<Arithmetic T>
+inline constexpr std::size_t LANES = REGISTER_BYTES / sizeof(T);
+
+/**
+ * @brief Lane mask.
+ * @tparam W Number of lanes.
+ */
+template<std::size_t W>
+    requires (W > 0)
+class Mask {
+private:
+    /*! @brief Lanes. */
+    std::array<bool, W> lanes;
+
+public:
+    /*! @brief Default constructor. */
+    Mask() noexcept = default;
+
+    /*! @brief Constructor that sets all lanes to same value. */
+    explicit Mask(const bool value) noexcept { lanes.fill(value); }
+
+    /*! @brief Subscript operator. */
+    inline auto operator[](const std::size_t lane) const noexcept -> bool {
+        return lanes[lane];
+    }
+
+    /*! @brief Subscript operator. */
+    inline auto& operator[](const std::size_t lane) noexcept {
+        return lanes[lane];
+    }
+
+    /*! @brief Check if any lane is set. */
+    inline auto Any() const noexcept -> bool {
+        auto result = false;
+        for(std::size_t i = 0; i < W; ++i)
+            result |= lanes[i];
+        return result;
+    }
+
+    /*! @brief Check if all lanes are set. */
+    inline auto All() const noexcept -> bool {
+        auto result = true;
+        for(std::size_t i = 0; i < W; ++i)
+            result &= lanes[i];
+        return result;
+    }
+
+    /*! @brief Check if no lane is set. */
+    inline auto None() const noexcept -> bool { return !Any(); }
+
+    /*! @brief Count set lanes. */
+    inline auto Count() const noexcept -> std::size_t {
+        std::size_t result = 0;
+        for(std::size_t i = 0; i < W; ++i)
+            result += lanes[i];
+        return result;
+    }
+
+    /*! @brief ! operator. */
+    inline Mask operator!() const noexcept {
+        Mask result;
+        for(std::size_t i = 0; i < W; ++i)
+            result.lanes[i] = !lanes[i];
+        return result;
+    }
+
+    /*! @brief & operator. */
+    friend inline Mask operator&(const Mask& left, const Mask& right)
+        noexcept {
+        Mask result;
+        for(std::size_t i = 0; i < W; ++i)
+            result.lanes[i] = left.lanes[i] && right.lanes[i];
+        return result;
+    }
+
+    /*! @brief | operator. */
+    friend inline Mask operator|(const Mask& left, const Mask& right)
+        noexcept {
+        Mask result;
+        for(std::size_t i = 0; i < W; ++i)
+            result.lanes[i] = left.lanes[i] || right.lanes[i];
+        return result;
+    }
+
+    /*! @brief ^ operator. */
+    friend inline Mask operator^(const Mask& left, const Mask& right)
+        noexcept {
+        Mask result;
+        for(std::size_t i = 0; i < W; ++i)
+            result.lanes[i] = left.lanes[i] != right.lanes[i];
+        return result;
+    }
+};
+
+/**
+ * @brief Packet of scalars, one per lane.
+ * @tparam T Arithmetic type of lanes.
+ * @tparam W Number of lanes.
+ */
+template<Arithmetic T, std::size_t W = LANES<T>>
+    requires (W > 0)
+class Pack {
+private:
+    /**
+     * @brief Lanes, aligned to their size rounded up to power of two and at
+     * most that of cache line, so any number of lanes stays well formed.
+     */
+    alignas(std::min(std::bit_ceil(sizeof(T) * W), std::size_t{64}))
+        std::array<T, W> lanes;
+
+    /**
+     * @brief Apply function to each lane.
+     * @param function Function of lane index.
+     */
+    template<typename F>
+    static inline auto Generate(F function) noexcept -> Pack {
+        Pack result;
+        for(std::size_t i = 0; i < W; ++i)
+            result.lanes[i] = function(i);
+        return result;
+    }
+
+    /**
+     * @brief Compare each lane.
+     * @param function Comparison function.
+     */
+    template<typename F>
+    static inline auto Compare(const Pack& left, const Pack& right,
+        F function) noexcept -> Mask<W> {
+        Mask<W> result;
+        for(std::size_t i = 0; i < W; ++i)
+            result[i] = function(left.lanes[i], right.lanes[i]);
+        return result;
+    }
+
+public:
+    /*! @brief Default constructor. */
+    Pack() noexcept = default;
+
+    /*! @brief Constructor that broadcasts number to all lanes. */
+    Pack(const T number) noexcept { lanes.fill(number); }
+
+    /*! @brief Constructor that accepts array of lanes. */
+    explicit Pack(const std::array<T, W>& array) noexcept : lanes{array} {}
+
+    /*! @brief Subscript operator. */
+    inline auto operator[](const std::size_t lane) const noexcept -> T {
+        return lanes[lane];
+    }
+
+    /*! @brief Subscript operator. */
+    inline auto& operator[](const std::size_t lane) noexcept {
+        return lanes[lane];
+    }
+
+    /*! @brief Compute square root of each lane. */
+    inline auto Sqrt() const noexcept -> Pack {
+        return Generate([this](const auto i) { return std::sqrt(lanes[i]); });
+    }
+
+    /*! @brief Compute absolute value of each lane. */
+    inline auto Abs() const noexcept -> Pack {
+        return Generate([this](const auto i) { return std::abs(lanes[i]); });
+    }
+
+    /*! @brief Compute horizontal minimum over all lanes. */
+    inline auto ReduceMin() const noexcept -> T {
+        auto result = lanes[0];
+        for(std::size_t i = 1; i < W; ++i)
+            result = lanes[i] < result ? lanes[i] : result;
+        return result;
+    }
+
+    /*! @brief Compute horizontal maximum over all lanes. */
+    inline auto ReduceMax() const noexcept -> T {
+        auto result = lanes[0];
+        for(std::size_t i = 1; i < W; ++i)
+            result = lanes[i] > result ? lanes[i] : result;
+        return result;
+    }
+
+    /*! @brief Unary - operator. */
+    inline Pack operator-() const noexcept {
+        return Generate([this](const auto i) { return -lanes[i]; });
+    }
+
+    /*! @brief += operator. */
+    inline Pack& operator+=(const Pack& pack) noexcept {
+        return *this = *this + pack;
+    }
+
+    /*! @brief -= operator. */
+    inline Pack& operator-=(const Pack& pack) noexcept {
+        return *this = *this - pack;
+    }
+
+    /*! @brief *= operator. */
+    inline Pack& operator*=(const Pack& pack) noexcept {
+        return *this = *this * pack;
+    }
+
+    /*! @brief /= operator. */
+    inline Pack& operator/=(const Pack& pack) noexcept {
+        return *this = *this / pack;
+    }
+
+    /*! @brief + operator. */
+    friend inline Pack operator+(const Pack& left, const Pack& right)
+        noexcept {
+        return Generate([&](const auto i) {
+            return left.lanes[i] + right.lanes[i]; });
+    }
+
+    /*! @brief - operator. */
+    friend inline Pack operator-(const Pack& left, const Pack& right)
+        noexcept {
+        return Generate([&](const auto i) {
+            return left.lanes[i] - right.lanes[i]; });
+    }
+
+    /*! @brief * operator. */
+    friend inline Pack operator*(const Pack& left, const Pack& right)
+        noexcept {
+        return Generate([&](const auto i) {
+            return left.lanes[i] * right.lanes[i]; });
+    }
+
+    /*! @brief / operator. */
+    friend inline Pack operator/(const Pack& left, const Pack& right)
+        noexcept {
+        return Generate([&](const auto i) {
+            return left.lanes[i] / right.lanes[i]; });
+    }
+
+    /*! @brief == operator. */
+    friend inline auto operator==(const Pack& left, const Pack& right)
+        noexcept -> Mask<W> {
+        return Compare(left, right, std::equal_to<>{});
+    }
+
+    /*! @brief != operator. */
+    friend inline auto operator!=(const Pack& left, const Pack& right)
+        noexcept -> Mask<W> {
+        return Compare(left, right, std::not_equal_to<>{});
+    }
+
+    /*! @brief < operator. */
+    friend inline auto operator<(const Pack& left, const Pack& right)
+        noexcept -> Mask<W> {
+        return Compare(left, right, std::less<>{});
+    }
+
+    /*! @brief <= operator. */
+    friend inline auto operator<=(const Pack& left, const Pack& right)
+        noexcept -> Mask<W> {
+        return Compare(left, right, std::less_equal<>{});
+    }
+
+    /*! @brief > operator. */
+    friend inline auto operator>(const Pack& left, const Pack& right)
+        noexcept -> Mask<W> {
+        return Compare(left, right, std::greater<>{});
+    }
+
+    /*! @brief >= operator. */
+    friend inline auto operator>=(const Pack& left, const Pack& right)
+        noexcept -> Mask<W> {
+        return Compare(left, right, std::greater_equal<>{});
+    }
+
+    /*! @brief Lane-wise minimum. */
+    friend inline auto Min(const Pack& left, const Pack& right) noexcept
+        -> Pack {
+        return Generate([&](const auto i) {
+            return left.lanes[i] < right.lanes[i] ?
+                left.lanes[i] : right.lanes[i]; });
+    }
+
+    /*! @brief Lane-wise maximum. */
+    friend inline auto Max(const Pack& left, const Pack& right) noexcept
+        -> Pack {
+        return Generate([&](const auto i) {
+            return left.lanes[i] > right.lanes[i] ?
+                left.lanes[i] : right.lanes[i]; });
+    }
+
+    /**
+     * @brief Blend packs lane-wise.
+     * @param mask Mask selecting lanes of first pack.
+     * @param left First pack.
+     * @param right Second pack.
+     * @return Lanes of first pack where mask is set, of second otherwise.
+     */
+    friend inline auto Select(const Mask<W>& mask, const Pack& left,
+        const Pack& right) noexcept -> Pack {
+        return Generate([&](const auto i) { return Blend(mask[i],
+            left.lanes[i], right.lanes[i]); });
+    }
+};
+
+/**
+ * @brief Packet of vectors stored as structure of arrays.
+ * @tparam T Arithmetic type of elements.
+ * @tparam N Positive number of elements.
+ * @tparam W Number of lanes.
+ */
+template<Arithmetic T, std::integral auto N, std::size_t W = LANES<T>>
+    requires (N > 0 && W > 0)
+class VectorPack {
+private:
+    /*! @brief Components, each holding all lanes. */
+    std::array<Pack<T, W>, N> components;
+
+    /**
+     * @brief Apply function to each component.
+     * @param function Function of component index.
+     */
+    template<typename F>
+    static inline auto Generate(F function) noexcept -> VectorPack {
+        VectorPack result;
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            result.components[i] = function(i);
+        return result;
+    }
+
+public:
+    /*! @brief Default constructor. */
+    VectorPack() noexcept = default;
+
+    /*! @brief Constructor that broadcasts vector to all lanes. */
+    VectorPack(const Vector<T, N>& vector) noexcept {
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            components[i] = Pack<T, W>(vector[i]);
+    }
+
+    /**
+     * @brief Constructor that accepts component packs.
+     * @param arguments Arguments.
+     */
+    template<typename... Args>
+        requires (sizeof...(Args) == N)
+    VectorPack(const Args&... arguments) noexcept :
+        components{Pack<T, W>(arguments)...} {}
+
+    /*! @brief Subscript operator to access component of all lanes. */
+    inline auto operator[](const std::integral auto index) const noexcept
+        -> const Pack<T, W>& {
+        return components[index];
+    }
+
+    /*! @brief Subscript operator to access component of all lanes. */
+    inline auto& operator[](const std::integral auto index) noexcept {
+        return components[index];
+    }
+
+    /**
+     * @brief Gather vector of single lane.
+     * @param lane Lane.
+     */
+    inline auto Get(const std::size_t lane) const noexcept -> Vector<T, N> {
+        Vector<T, N> result;
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            result[i] = components[i][lane];
+        return result;
+    }
+
+    /**
+     * @brief Scatter vector to single lane.
+     * @param lane Lane.
+     * @param vector Vector.
+     */
+    inline void Set(const std::size_t lane, const Vector<T, N>& vector)
+        noexcept {
+        for(std::size_t i = 0; i < static_cast<std::size_t>(N); ++i)
+            components[i][lane] = vector[i];
+    }
+
+    /*! @brief Compute length of each lane. */
+    inline auto Length() const noexcept -> Pack<T, W> {
+        return Length2().Sqrt();
+    }
+
+    /*! @brief Compute squared length of each lane. */
+    inline auto Length2() const noexcept -> Pack<T, W> { return Dot(*this); }
+
+    /**
+     * @brief Compute dot product of each lane with another packet.
+     * @param pack Packet.
+     */
+    inline auto Dot(const VectorPack& pack) const noexcept -> Pack<T, W> {
+        auto result = components[0] * pack.components[0];
+        for(std::size_t i = 1; i < static_cast<std::size_t>(N); ++i)
+            result += components[i] * pack.components[i];
+        return result;
+    }
+
+    /**
+     * @brief Compute cross product of each lane with another packet.
+     * @param pack Packet.
+     */
+    inline auto Cross(const VectorPack& pack) const noexcept -> VectorPack {
+        static_assert(N == 3);
+        const auto& a = components;
+        const auto& b = pack.components;
+        return VectorPack(a[1] * b[2] - a[2] * b[1],
+                          a[2] * b[0] - a[0] * b[2],
+                          a[0] * b[1] - a[1] * b[0]);
+    }
+
+    /**
+     * @brief Normalize each lane.
+     * @return Normalized packet.
+     */
+    inline auto Normalize() const noexcept -> VectorPack {
+        return *this * (Pack<T, W>(T{1}) / Length());
+    }
+
+    /**
+     * @brief Reflect each lane.
+     * @param normal Normal packet.
+     * @return Reflected packet.
+     */
+    inline auto Reflect(const VectorPack& normal) const noexcept
+        -> VectorPack {
+        static_assert(N == 3);
+        return *this - normal * (Pack<T, W>(T{2}) * Dot(normal));
+    }
+
+    /**
+     * @brief Refract each lane.
+     * @param normal Normal packet.
+     * @param ratio Refraction ratio of each lane.
+     * @return Refracted packet.
+     */
+    inline auto Refract(const VectorPack& normal, const Pack<T, W>& ratio)
+        const noexcept -> VectorPack {
+        static_assert(N == 3);
+        const auto cos_theta = Min((-*this).Dot(normal), Pack<T, W>(T{1}));
+        const auto perpendicular = (*this + normal * cos_theta) * ratio;
+        const auto parallel = normal *
+            -(Pack<T, W>(T{1}) - perpendicular.Length2()).Abs().Sqrt();
+        return perpendicular + parallel;
+    }
+
+    /*! @brief Unary - operator. */
+    inline VectorPack operator-() const noexcept {
+        return Generate([this](const auto i) { return -components[i]; });
+    }
+
+    /*! @brief += operator. */
+    inline VectorPack& operator+=(const VectorPack& pack) noexcept {
+        return *this = *this + pack;
+    }
+
+    /*! @brief -= operator. */
+    inline VectorPack& operator-=(const VectorPack& pack) noexcept {
+        return *this = *this - pack;
+    }
+
+    /*! @brief *= operator. */
+    inline VectorPack& operator*=(const VectorPack& pack) noexcept {
+        return *this = *this * pack;
+    }
+
+    /*! @brief *= operator. */
+    inline VectorPack& operator*=(const Pack<T, W>& pack) noexcept {
+        return *this = *this * pack;
+    }
+
+    /*! @brief /= operator. */
+    inline VectorPack& operator/=(const Pack<T, W>& pack) noexcept {
+        return *this = *this / pack;
+    }
+
+    /*! @brief + operator. */
+    friend inline VectorPack operator+(const VectorPack& left,
+        const VectorPack& right) noexcept {
+        return Generate([&](const auto i) {
+            return left.components[i] + right.components[i]; });
+    }
+
+    /*! @brief - operator. */
+    friend inline VectorPack operator-(const VectorPack& left,
+        const VectorPack& right) noexcept {
+        return Generate([&](const auto i) {
+            return left.components[i] - right.components[i]; });
+    }
+
+    /*! @brief * operator. */
+    friend inline VectorPack operator*(const VectorPack& left,
+        const VectorPack& right) noexcept {
+        return Generate([&](const auto i) {
+            return left.components[i] * right.components[i]; });
+    }
+
+    /*! @brief * operator. */
+    friend inline VectorPack operator*(const VectorPack& left,
+        const Pack<T, W>& right) noexcept {
+        return Generate([&](const auto i) {
+            return left.components[i] * right; });
+    }
+
+    /*! @brief * operator. */
+    friend inline VectorPack operator*(const Pack<T, W>& left,
+        const VectorPack& right) noexcept {
+        return right * left;
+    }
+
+    /*! @brief / operator. */
+    friend inline VectorPack operator/(const VectorPack& left,
+        const Pack<T, W>& right) noexcept {
+        return left * (Pack<T, W>(T{1}) / right);
+    }
+
+    /**
+     * @brief Blend packets lane-wise.
+     * @param mask Mask selecting lanes of first packet.
+     * @param left First packet.
+     * @param right Second packet.
+     * @return Lanes of first packet where mask is set, of second otherwise.
+     */
+    friend inline auto Select(const Mask<W>& mask, const VectorPack& left,
+        const VectorPack& right) noexcept -> VectorPack {
+        return Generate([&](const auto i) {
+            return Select(mask, left.components[i], right.components[i]); });
+    }
+};
+
 } // namespace math
+
+namespace math::detail {
+
+/*! @brief Check if values are equal within tolerance. */
+constexpr auto Near(const float left, const float right) noexcept -> bool {
+    return Abs(left - right) < 1e-6f;
+}
+
+/*! @brief Check if vectors are equal within tolerance. */
+template<std::integral auto N>
+constexpr auto Near(const Vector<float, N>& left,
+    const Vector<float, N>& right) noexcept -> bool {
+    for(auto i = 0; i < N; ++i)
+        if(!Near(left[i], right[i]))
+            return false;
+    return true;
+}
+
+/*! @brief Compile-time checks of vector operations. */
+namespace checks {
+
+constexpr Vector<float, 3> X{1.0f, 0.0f, 0.0f};
+constexpr Vector<float, 3> Y{0.0f, 1.0f, 0.0f};
+constexpr Vector<float, 3> Z{0.0f, 0.0f, 1.0f};
+constexpr Vector<float, 3> A{1.0f, -2.0f, 3.0f};
+constexpr Vector<float, 4> B{1.0f, 2.0f, 3.0f, 4.0f};
+
+static_assert(Sqrt(0.0f) == 0.0f && Sqrt(1.0f) == 1.0f);
+static_assert(Sqrt(4.0) == 2.0 && Sqrt(144.0f) == 12.0f && Sqrt(16) == 4.0);
+static_assert(Abs(Sqrt(2.0) - 1.4142135623730951) < 1e-15);
+static_assert(Near(Sqrt(1e-8f), 1e-4f) && Near(Sqrt(0.25f), 0.5f));
+static_assert(Sqrt(-1.0f) != Sqrt(-1.0f));
+static_assert(Abs(-2.5f) == 2.5f && Abs(3) == 3);
+
+static_assert(A + X == Vector<float, 3>{2.0f, -2.0f, 3.0f});
+static_assert(A - X == Vector<float, 3>{0.0f, -2.0f, 3.0f});
+static_assert(A * A == Vector<float, 3>{1.0f, 4.0f, 9.0f});
+static_assert(2 * A == A * 2.0f && A * 2.0f == Vector<float, 3>{2, -4, 6});
+static_assert(A / 2.0f == Vector<float, 3>{0.5f, -1.0f, 1.5f});
+static_assert(-A == Vector<float, 3>{-1.0f, 2.0f, -3.0f});
+static_assert(B + B == B * 2 && -B == B * -1.0f);
+static_assert((Vector<float, 3>{A} += X) == A + X);
+static_assert((Vector<float, 3>{A} -= X) == A - X);
+static_assert((Vector<float, 3>{A} *= A) == A * A);
+static_assert((Vector<float, 3>{A} *= 3) == 3 * A);
+static_assert((Vector<float, 3>{A} /= 4) == A / 4);
+
+static_assert(A.Dot(A) == 14.0f && Dot(A, X) == 1.0f && B.Length2() == 30.0f);
+static_assert(Length2(A) == 14.0f && Length(Vector<float, 2>{3, 4}) == 5.0f);
+static_assert(X.Cross(Y) == Z && Cross(Y, Z) == X && Cross(Z, X) == Y);
+static_assert(Normalize(Vector<float, 3>{0.0f, 3.0f, 4.0f}) ==
+    Vector<float, 3>{0.0f, 3.0f / 5.0f, 4.0f / 5.0f} * 1.0f);
+static_assert(Near(Normalize(A).Length(), 1.0f));
+static_assert(Reflect(Vector<float, 3>{1.0f, -1.0f, 0.0f}, Y) ==
+    Vector<float, 3>{1.0f, 1.0f, 0.0f});
+static_assert(Refract(-Y, Y, 1.0f) == -Y);
+static_assert(Near(Refract(Normalize(Vector<float, 3>{1.0f, -1.0f, 0.0f}), Y,
+    1.0f), Normalize(Vector<float, 3>{1.0f, -1.0f, 0.0f})));
+
+static_assert(Vector<float, 3>{Lazy(A) + 2.0f * Lazy(X) - Lazy(Y)} ==
+    A + 2.0f * X - Y);
+static_assert(Vector<float, 3>{-(Lazy(A) * A) / 2} == -(A * A) / 2);
+
+} // namespace checks
+
+} // namespace math::detail
@@ -25,22 +25,39 @@ fi
 
 # Build
 FLAGS="-std=c++23 -Wall -Wextra -Wpedantic -Werror -O3"
+if [ -n "$FAST_MATH" ]; then
+    FLAGS="$FLAGS -DRAY_FAST_MATH"
+fi
 MODULES="-fprebuilt-module-path=bin -fprebuilt-module-path=$LIB/bin"
 mkdir -p bin/
 (cd $LIB && exe ./build.sh)
 exe clang++ $FLAGS -x c++-module include/Random.ccm --precompile $MODULES -o bin/Random.pcm
 exe clang++ $FLAGS -x c++-module include/Ray.ccm --precompile $MODULES -o bin/Ray.pcm
+exe clang++ $FLAGS -x c++-module include/Sampler.ccm --precompile $MODULES -o bin/Sampler.pcm
 exe clang++ $FLAGS -x c++-module include/Material.ccm --precompile $MODULES -o bin/Material.pcm
 exe clang++ $FLAGS -x c++-module include/Object.ccm --precompile $MODULES -o bin/Object.pcm
+exe clang++ $FLAGS -x c++-module include/Bvh.ccm --precompile $MODULES -o bin/Bvh.pcm
+exe clang++ $FLAGS -x c++-module include/Spheres.ccm --precompile $MODULES -o bin/Spheres.pcm
+exe clang++ $FLAGS -x c++-module include/Scene.ccm --precompile $MODULES -o bin/Scene.pcm
+exe clang++ $FLAGS -x c++-module include/Writer.ccm --precompile $MODULES -o bin/Writer.pcm
 exe clang++ $FLAGS -x c++-module include/Camera.ccm --precompile $MODULES -o bin/Camera.pcm
+exe clang++ $FLAGS src/Sampler.cc $MODULES -c -o bin/Sampler-src.o
 exe clang++ $FLAGS src/Material.cc $MODULES -c -o bin/Material-src.o
 exe clang++ $FLAGS src/Object.cc $MODULES -c -o bin/Object-src.o
+exe clang++ $FLAGS src/Bvh.cc $MODULES -c -o bin/Bvh-src.o
+exe clang++ $FLAGS src/Scene.cc $MODULES -c -o bin/Scene-src.o
+exe clang++ $FLAGS src/Writer.cc $MODULES -c -o bin/Writer-src.o
 exe clang++ $FLAGS src/Camera.cc $MODULES -c -o bin/Camera-src.o
 exe clang++ $FLAGS src/main.cc $MODULES -c -o bin/main.o
 exe clang++ $FLAGS bin/Random.pcm $MODULES -c -o bin/Random.o
 exe clang++ $FLAGS bin/Ray.pcm $MODULES -c -o bin/Ray.o
+exe clang++ $FLAGS bin/Sampler.pcm $MODULES -c -o bin/Sampler.o
 exe clang++ $FLAGS bin/Material.pcm $MODULES -c -o bin/Material.o
 exe clang++ $FLAGS bin/Object.pcm $MODULES -c -o bin/Object.o
+exe clang++ $FLAGS bin/Bvh.pcm $MODULES -c -o bin/Bvh.o
+exe clang++ $FLAGS bin/Spheres.pcm $MODULES -c -o bin/Spheres.o
+exe clang++ $FLAGS bin/Scene.pcm $MODULES -c -o bin/Scene.o
+exe clang++ $FLAGS bin/Writer.pcm $MODULES -c -o bin/Writer.o
 exe clang++ $FLAGS bin/Camera.pcm $MODULES -c -o bin/Camera.o
-exe clang++ bin/main.o bin/Camera.o bin/Camera-src.o bin/Material.o bin/Material-src.o bin/Object.o bin/Object-src.o bin/Random.o bin/Ray.o -o raytracer
+exe clang++ bin/main.o bin/Bvh.o bin/Bvh-src.o bin/Camera.o bin/Camera-src.o bin/Material.o bin/Material-src.o bin/Object.o bin/Object-src.o bin/Random.o bin/Ray.o bin/Sampler.o bin/Sampler-src.o bin/Scene.o bin/Scene-src.o bin/Spheres.o bin/Writer.o bin/Writer-src.o $LIB/libmath.a -o raytracer
 exit 0
@@ -0,0 +1,470 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <execution>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+import Object;
+import Ray;
+
+module Bvh;
+
+namespace ray {
+
+namespace {
+
+/*! @brief Cost of visiting node relative to intersecting object. */
+constexpr float TRAVERSAL_COST = 1.0f;
+/*! @brief Number of objects worth spreading over threads. */
+constexpr std::size_t PARALLEL_SIZE = 1 << 14;
+
+/*! @brief Object referenced during build. */
+struct Reference {
+    /*! @brief Box bounding object. */
+    AABB3f box;
+    /*! @brief Centroid of box. */
+    Vector3f centroid;
+    /*! @brief Index of object in container. */
+    std::uint32_t index;
+    /*! @brief Morton code of centroid. */
+    std::uint32_t code;
+};
+
+/*! @brief Centroid bin. */
+struct Bin {
+    /*! @brief Box bounding objects in bin. */
+    AABB3f box;
+    /*! @brief Number of objects in bin. */
+    std::size_t count{0};
+};
+
+/*! @brief Bins of all three axes. */
+using Bins = std::array<std::array<Bin, BVH::BINS>, 3>;
+
+/*! @brief Best split of node. */
+struct Split {
+    /*! @brief Axis. */
+    int axis{-1};
+    /*! @brief Last bin of left child. */
+    std::size_t bin{0};
+    /*! @brief Sum of surface areas weighted by object counts. */
+    float cost{0.0f};
+};
+
+/**
+ * @brief Get number of chunks to split range into, one per hardware thread
+ * for large ranges and one otherwise.
+ * @param count Number of elements.
+ */
+auto Chunks(const std::size_t count) noexcept -> std::size_t {
+    if(count < PARALLEL_SIZE)
+        return 1;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Call function for each chunk of range, each on its own thread.
+ * @param begin First element.
+ * @param end One past last element.
+ * @param function Function that accepts chunk index and its range.
+ */
+template<typename F>
+void ForEachChunk(const std::size_t begin, const std::size_t end,
+    F function) {
+    const auto count = end - begin;
+    const auto chunks = Chunks(count);
+    std::vector<std::thread> threads;
+    threads.reserve(chunks - 1);
+    for(std::size_t i = 1; i < chunks; ++i)
+        threads.emplace_back(function, i, begin + count * i / chunks,
+            begin + count * (i + 1) / chunks);
+    function(std::size_t{0}, begin, begin + count / chunks);
+    for(auto& thread : threads)
+        thread.join();
+}
+
+/**
+ * @brief Spread lower ten bits so that two zero bits follow each of them.
+ * @param value Value.
+ */
+constexpr auto SpreadBits(std::uint32_t value) noexcept -> std::uint32_t {
+    value = (value | (value << 16)) & 0x030000ffu;
+    value = (value | (value << 8)) & 0x0300f00fu;
+    value = (value | (value << 4)) & 0x030c30c3u;
+    return (value | (value << 2)) & 0x09249249u;
+}
+
+/**
+ * @brief Get 30-bit Morton code of point within box.
+ * @param point Point.
+ * @param box Box.
+ */
+auto Morton(const Vector3f& point, const AABB3f& box) noexcept ->
+    std::uint32_t {
+    std::uint32_t code{0};
+    for(auto i = 0; i < 3; ++i) {
+        const auto extent = box.Max()[i] - box.Min()[i];
+        const auto unit = extent > 0.0f ?
+            (point[i] - box.Min()[i]) / extent : 0.0f;
+        const auto cell = std::min(1023.0f, std::max(0.0f, unit * 1024.0f));
+        code |= SpreadBits(static_cast<std::uint32_t>(cell)) << (2 - i);
+    }
+    return code;
+}
+
+/*! @brief Top-down builder, common to both methods. */
+class Builder {
+protected:
+    /*! @brief Nodes built. */
+    std::vector<BVH::Node>& nodes;
+    /*! @brief References to objects, partitioned as nodes are built. */
+    std::vector<Reference>& references;
+    /*! @brief Number of nodes allocated. */
+    std::atomic<std::uint32_t> allocated{1};
+    /*! @brief Number of threads still free to build subtrees. */
+    std::atomic<int> free_threads;
+
+    /*! @brief Allocate pair of sibling nodes. */
+    auto Allocate() noexcept -> std::uint32_t {
+        return allocated.fetch_add(2, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Make node leaf.
+     * @param node Index of node.
+     * @param begin First reference.
+     * @param end One past last reference.
+     */
+    void MakeLeaf(const std::size_t node, const std::size_t begin,
+        const std::size_t end) noexcept {
+        nodes[node].offset = static_cast<std::uint32_t>(begin);
+        nodes[node].count = static_cast<std::uint32_t>(end - begin);
+    }
+
+    /**
+     * @brief Run both functions, on separate threads if range is large and
+     * thread is free.
+     * @param count Number of objects below both.
+     * @param left First function.
+     * @param right Second function.
+     */
+    template<typename L, typename R>
+    void Fork(const std::size_t count, L left, R right) {
+        const auto large = count >= PARALLEL_SIZE;
+        if(!large || free_threads.fetch_sub(1) <= 0) {
+            if(large)
+                ++free_threads;
+            left();
+            right();
+            return;
+        }
+        std::thread thread(left);
+        right();
+        thread.join();
+        ++free_threads;
+    }
+
+public:
+    /*! @brief Constructor. */
+    Builder(std::vector<BVH::Node>& nodes, std::vector<Reference>& references)
+        noexcept : nodes(nodes), references(references),
+        free_threads{static_cast<int>(std::thread::hardware_concurrency()) -
+        1} {}
+
+    /*! @brief Get number of nodes allocated. */
+    auto Allocated() const noexcept -> std::size_t { return allocated; }
+};
+
+/*! @brief Builder by surface area heuristic over binned centroids. */
+class SahBuilder : public Builder {
+private:
+    /**
+     * @brief Bin centroids of range along all axes, in parallel for large
+     * ranges.
+     * @param begin First reference.
+     * @param end One past last reference.
+     * @param centroids Box bounding centroids of range.
+     */
+    auto Fill(const std::size_t begin, const std::size_t end,
+        const AABB3f& centroids) const -> Bins {
+        const auto low = centroids.Min();
+        const auto extent = centroids.Extent();
+        std::vector<Bins> partial(Chunks(end - begin));
+        ForEachChunk(begin, end, [&](const std::size_t chunk,
+            const std::size_t first, const std::size_t last) {
+            auto& bins = partial[chunk];
+            for(auto i = first; i < last; ++i) {
+                for(auto axis = 0; axis < 3; ++axis) {
+                    if(!(extent[axis] > 0.0f))
+                        continue;
+                    const auto bin = std::min(BVH::BINS - 1,
+                        static_cast<std::size_t>(
+                        (references[i].centroid[axis] - low[axis]) *
+                        (static_cast<float>(BVH::BINS) / extent[axis])));
+                    bins[axis][bin].box = bins[axis][bin].box.Union(
+                        references[i].box);
+                    ++bins[axis][bin].count;
+                }
+            }
+        });
+        for(std::size_t chunk = 1; chunk < partial.size(); ++chunk)
+            for(auto axis = 0; axis < 3; ++axis)
+                for(std::size_t bin = 0; bin < BVH::BINS; ++bin) {
+                    auto& total = partial[0][axis][bin];
+                    const auto& part = partial[chunk][axis][bin];
+                    total.box = total.box.Union(part.box);
+                    total.count += part.count;
+                }
+        return partial[0];
+    }
+
+    /**
+     * @brief Find split of least cost.
+     * @param begin First reference.
+     * @param end One past last reference.
+     * @param centroids Box bounding centroids of range.
+     */
+    auto FindSplit(const std::size_t begin, const std::size_t end,
+        const AABB3f& centroids) const -> Split {
+        const auto bins = Fill(begin, end, centroids);
+        Split best;
+        for(auto axis = 0; axis < 3; ++axis) {
+            if(!(centroids.Extent()[axis] > 0.0f))
+                continue;
+
+            std::array<float, BVH::BINS> right_costs;
+            AABB3f right;
+            std::size_t right_count{0};
+            for(auto bin = BVH::BINS - 1; bin > 0; --bin) {
+                right = right.Union(bins[axis][bin].box);
+                right_count += bins[axis][bin].count;
+                right_costs[bin - 1] = right.SurfaceArea() * right_count;
+            }
+
+            AABB3f left;
+            std::size_t left_count{0};
+            for(std::size_t bin = 0; bin < BVH::BINS - 1; ++bin) {
+                left = left.Union(bins[axis][bin].box);
+                left_count += bins[axis][bin].count;
+                const auto cost = left.SurfaceArea() * left_count +
+                    right_costs[bin];
+                if(left_count > 0 && left_count < end - begin &&
+                    (best.axis < 0 || cost < best.cost))
+                    best = Split{axis, bin, cost};
+            }
+        }
+        return best;
+    }
+
+public:
+    using Builder::Builder;
+
+    /**
+     * @brief Fill node with range of references, splitting it recursively
+     * while split is cheaper than leaf.
+     * @param node Index of node.
+     * @param begin First reference.
+     * @param end One past last reference.
+     * @param depth Depth of node.
+     */
+    void Subdivide(const std::size_t node, const std::size_t begin,
+        const std::size_t end, const std::size_t depth) {
+        AABB3f box;
+        AABB3f centroids;
+        for(auto i = begin; i < end; ++i) {
+            box = box.Union(references[i].box);
+            centroids = centroids.Union(references[i].centroid);
+        }
+        nodes[node].box = box;
+
+        const auto count = end - begin;
+        const auto split = count > 1 && depth + 1 < BVH::MAX_DEPTH ?
+            FindSplit(begin, end, centroids) : Split{};
+        const auto split_cost = TRAVERSAL_COST +
+            split.cost / box.SurfaceArea();
+        if(split.axis < 0 || (count <= BVH::LEAF_SIZE &&
+            split_cost >= static_cast<float>(count))) {
+            MakeLeaf(node, begin, end);
+            return;
+        }
+
+        const auto low = centroids.Min()[split.axis];
+        const auto scale = static_cast<float>(BVH::BINS) /
+            centroids.Extent()[split.axis];
+        const auto middle = std::partition(references.begin() + begin,
+            references.begin() + end, [&](const Reference& reference) {
+                return std::min(BVH::BINS - 1, static_cast<std::size_t>(
+                    (reference.centroid[split.axis] - low) * scale)) <=
+                    split.bin;
+            }) - references.begin();
+
+        const auto left = Allocate();
+        nodes[node].offset = left;
+        nodes[node].count = 0;
+        Fork(count,
+            [=, this] { Subdivide(left, begin, middle, depth + 1); },
+            [=, this] { Subdivide(left + 1, middle, end, depth + 1); });
+    }
+};
+
+/*! @brief Builder splitting sorted Morton codes at highest differing bit. */
+class MortonBuilder : public Builder {
+public:
+    using Builder::Builder;
+
+    /**
+     * @brief Fill node with range of references sorted by Morton code,
+     * splitting it recursively while it holds more than leaf size.
+     * @param node Index of node.
+     * @param begin First reference.
+     * @param end One past last reference.
+     * @param depth Depth of node.
+     * @return Box bounding node.
+     */
+    auto Subdivide(const std::size_t node, const std::size_t begin,
+        const std::size_t end, const std::size_t depth) -> AABB3f {
+        const auto count = end - begin;
+        if(count <= BVH::LEAF_SIZE || depth + 1 >= BVH::MAX_DEPTH) {
+            AABB3f box;
+            for(auto i = begin; i < end; ++i)
+                box = box.Union(references[i].box);
+            nodes[node].box = box;
+            MakeLeaf(node, begin, end);
+            return box;
+        }
+
+        const auto first = references[begin].code;
+        const auto last = references[end - 1].code;
+        auto middle = begin + count / 2;
+        if(first != last) {
+            const auto bit = std::uint32_t{1} << (31 - std::countl_zero(
+                first ^ last));
+            middle = std::partition_point(references.begin() + begin,
+                references.begin() + end, [bit](const Reference& reference) {
+                    return (reference.code & bit) == 0;
+                }) - references.begin();
+        }
+
+        const auto left = Allocate();
+        AABB3f left_box;
+        AABB3f right_box;
+        Fork(count,
+            [=, this, &left_box] {
+                left_box = Subdivide(left, begin, middle, depth + 1);
+            },
+            [=, this, &right_box] {
+                right_box = Subdivide(left + 1, middle, end, depth + 1);
+            });
+        nodes[node].box = left_box.Union(right_box);
+        nodes[node].offset = left;
+        nodes[node].count = 0;
+        return nodes[node].box;
+    }
+};
+
+} // namespace
+
+BVH::BVH(const Objects& container, const Method method) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto& source = container.GetObjects();
+
+    std::vector<Reference> references(source.size());
+    std::vector<AABB3f> bounds(Chunks(source.size()));
+    ForEachChunk(0, source.size(), [&](const std::size_t chunk,
+        const std::size_t first, const std::size_t last) {
+        for(auto i = first; i < last; ++i) {
+            const auto box = source[i]->BoundingBox();
+            references[i] = Reference{box, box.Centroid(),
+                static_cast<std::uint32_t>(i), 0};
+            bounds[chunk] = bounds[chunk].Union(references[i].centroid);
+        }
+    });
+
+    if(!references.empty()) {
+        nodes.resize(2 * references.size());
+        std::size_t allocated;
+        if(method == Method::SAH) {
+            SahBuilder builder(nodes, references);
+            builder.Subdivide(0, 0, references.size(), 0);
+            allocated = builder.Allocated();
+        } else {
+            const auto centroids = std::accumulate(bounds.begin(),
+                bounds.end(), AABB3f(), [](const AABB3f& left,
+                const AABB3f& right) { return left.Union(right); });
+            ForEachChunk(0, references.size(), [&](const std::size_t,
+                const std::size_t first, const std::size_t last) {
+                for(auto i = first; i < last; ++i)
+                    references[i].code = Morton(references[i].centroid,
+                        centroids);
+            });
+            std::sort(std::execution::par, references.begin(),
+                references.end(), [](const Reference& left,
+                const Reference& right) { return left.code < right.code; });
+            MortonBuilder builder(nodes, references);
+            builder.Subdivide(0, 0, references.size(), 0);
+            allocated = builder.Allocated();
+        }
+        nodes.resize(allocated);
+        nodes.shrink_to_fit();
+    }
+
+    objects.resize(references.size());
+    ForEachChunk(0, references.size(), [&](const std::size_t,
+        const std::size_t first, const std::size_t last) {
+        for(auto i = first; i < last; ++i)
+            objects[i] = source[references[i].index];
+    });
+    statistics.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    statistics.objects = objects.size();
+    statistics.nodes = nodes.size();
+    if(nodes.empty())
+        return;
+    const auto root_area = nodes.front().box.SurfaceArea();
+    std::vector<std::pair<std::uint32_t, std::size_t>> stack{{0, 0}};
+    while(!stack.empty()) {
+        const auto [index, depth] = stack.back();
+        stack.pop_back();
+        const auto& node = nodes[index];
+        const auto weight = root_area > 0.0f ?
+            node.box.SurfaceArea() / root_area : 1.0f;
+        if(node.count > 0) {
+            ++statistics.leaves;
+            statistics.depth = std::max(statistics.depth, depth);
+            statistics.cost += weight * static_cast<float>(node.count);
+        } else {
+            statistics.cost += weight * TRAVERSAL_COST;
+            stack.emplace_back(node.offset, depth + 1);
+            stack.emplace_back(node.offset + 1, depth + 1);
+        }
+    }
+}
+
+auto BVH::CheckHit(const Ray& ray, const Interval interval) const ->
+    std::optional<Hit> {
+    std::optional<Hit> hit;
+    auto closest = interval.Max();
+    Traverse(nodes, ray, interval.Min(), closest,
+        [&](const std::uint32_t first, const std::uint32_t count) {
+            for(auto i = first; i < first + count; ++i)
+                if(auto new_hit = objects[i]->CheckHit(ray,
+                    Interval{interval.Min(), closest})) {
+                    closest = new_hit->distance;
+                    hit = std::move(new_hit);
+                }
+        });
+    return hit;
+}
+
+} // namespace ray
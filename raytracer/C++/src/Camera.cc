@@ -1,26 +1,401 @@
 module;
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <limits>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
 #include <vector>
 
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
-import Random;
+import Bvh;
+import Matrix;
 
 module Camera;
 
 namespace ray {
 
+namespace {
+
+/*! @brief Number of rays traced by calling thread. */
+thread_local std::uint64_t traced_rays{0};
+
+/*! @brief Largest size of square packets that fit into one packet. */
+constexpr int MAX_PACKET_SIZE = 8;
+static_assert(MAX_PACKET_SIZE * MAX_PACKET_SIZE <= Scene::PACKET_SIZE);
+
+/*! @brief Number of types of materials of flat scenes. */
+constexpr auto MATERIAL_TYPES = std::variant_size_v<Scene::MaterialVariant>;
+
+/*! @brief Queue of paths of wavefront as structure of arrays. */
+struct Paths {
+    /*! @brief Rays to trace next. */
+    std::vector<Ray> rays;
+    /*! @brief Products of attenuations so far. */
+    std::vector<Color> throughputs;
+    /*! @brief Light gathered so far. */
+    std::vector<Color> radiances;
+    /*! @brief Probability densities of materials scattering rays. */
+    std::vector<float> pdfs;
+    /*! @brief Indices of pixels within block. */
+    std::vector<std::uint32_t> pixels;
+    /*! @brief Numbers of rays so far. */
+    std::vector<int> depths;
+
+    /*! @brief Get number of paths. */
+    [[nodiscard]] inline auto Size() const noexcept -> std::size_t {
+        return rays.size();
+    }
+
+    /**
+     * @brief Append path.
+     * @param ray Ray to trace next.
+     * @param throughput Product of attenuations so far.
+     * @param radiance Light gathered so far.
+     * @param pdf Probability density of material scattering ray.
+     * @param pixel Index of pixel within block.
+     * @param depth Number of rays so far.
+     */
+    inline void Push(const Ray& ray, const Color& throughput,
+        const Color& radiance, const float pdf, const std::uint32_t pixel,
+        const int depth) {
+        rays.push_back(ray);
+        throughputs.push_back(throughput);
+        radiances.push_back(radiance);
+        pdfs.push_back(pdf);
+        pixels.push_back(pixel);
+        depths.push_back(depth);
+    }
+
+    /*! @brief Remove all paths, keeping storage. */
+    inline void Clear() noexcept {
+        rays.clear();
+        throughputs.clear();
+        radiances.clear();
+        pdfs.clear();
+        pixels.clear();
+        depths.clear();
+    }
+};
+
+/*! @brief Storage of wavefront, reused by calling thread across blocks. */
+struct Wavefront {
+    /*! @brief Samplers of pixels. */
+    std::vector<Sampler> samplers;
+    /*! @brief Sums of samples of pixels. */
+    std::vector<Color> sums;
+    /*! @brief Numbers of samples pixels have yet to start. */
+    std::vector<int> samples;
+    /*! @brief Pixels without path. */
+    std::vector<std::uint32_t> idle;
+    /*! @brief Paths to intersect. */
+    Paths paths;
+    /*! @brief Paths surviving shading. */
+    Paths survivors;
+    /*! @brief Hits of paths. */
+    std::vector<std::optional<Scene::Hit>> hits;
+    /*! @brief Paths that missed, then paths by type of hit material. */
+    std::array<std::vector<std::uint32_t>, 1 + MATERIAL_TYPES> buckets;
+};
+
+/*! @brief Checkpoint file of progressive rendering. */
+constexpr auto CHECKPOINT = "checkpoint.bin";
+
+/*! @brief Magic number and version at start of checkpoint file. */
+constexpr std::array<char, 8> CHECKPOINT_MAGIC{'R', 'A', 'Y', 'C', 'H', 'K',
+    'P', '2'};
+
+static_assert(std::is_trivially_copyable_v<Sampler>,
+    "samplers must be stored in checkpoints as they are");
+
+/*! @brief Accumulated state of progressive rendering, one per pixel. */
+struct Progress {
+    /*! @brief Sums of samples. */
+    std::vector<Color> sums;
+    /*! @brief Numbers of samples. */
+    std::vector<std::uint32_t> samples;
+    /*! @brief Samplers, where their numbers go on. */
+    std::vector<Sampler> samplers;
+};
+
+/**
+ * @brief Get name of image file.
+ * @param format Format.
+ */
+auto ImageName(const Writer::Format format) -> std::string {
+    return "image" + std::string(Writer::Extension(format));
+}
+
+/*! @brief FNV-1a hash of values, identifying what checkpoint resumes. */
+class Fingerprint {
+private:
+    /*! @brief Hash so far. */
+    std::uint64_t hash{0xcbf29ce484222325};
+
+public:
+    /**
+     * @brief Add bytes of values.
+     * @tparam T Type of values, without padding.
+     * @param values Values.
+     */
+    template<typename T>
+    requires std::has_unique_object_representations_v<T> ||
+        std::is_floating_point_v<T>
+    void Add(const std::span<const T> values) noexcept {
+        const auto bytes = std::as_bytes(values);
+        for(const auto& byte : bytes) {
+            hash ^= static_cast<std::uint64_t>(byte);
+            hash *= 0x100000001b3;
+        }
+    }
+
+    /**
+     * @brief Add bytes of elements of vector.
+     * @param vector Vector.
+     */
+    void Add(const Vector3f& vector) noexcept {
+        const std::array<float, 3> elements{vector[0], vector[1], vector[2]};
+        Add(std::span<const float>(elements));
+    }
+
+    /**
+     * @brief Add bytes of value.
+     * @tparam T Type of value, without padding.
+     * @param value Value.
+     */
+    template<typename T>
+    requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+    void Add(const T value) noexcept {
+        Add(std::span<const T>(&value, 1));
+    }
+
+    /*! @brief Get hash. */
+    [[nodiscard]] auto Get() const noexcept -> std::uint64_t {
+        return hash;
+    }
+};
+
+/**
+ * @brief Add type and parameters of material to fingerprint.
+ * @param fingerprint Fingerprint.
+ * @param material Material.
+ */
+void AddMaterial(Fingerprint& fingerprint, const Lambertian& material)
+    noexcept {
+    fingerprint.Add('L');
+    fingerprint.Add(material.GetAlbedo());
+}
+
+/**
+ * @brief Add type and parameters of material to fingerprint.
+ * @param fingerprint Fingerprint.
+ * @param material Material.
+ */
+void AddMaterial(Fingerprint& fingerprint, const Metal& material) noexcept {
+    fingerprint.Add('M');
+    fingerprint.Add(material.GetAlbedo());
+    fingerprint.Add(material.GetFuzziness());
+}
+
+/**
+ * @brief Add type and parameters of material to fingerprint.
+ * @param fingerprint Fingerprint.
+ * @param material Material.
+ */
+void AddMaterial(Fingerprint& fingerprint, const Dielectric& material)
+    noexcept {
+    fingerprint.Add('D');
+    fingerprint.Add(material.GetRefractionIndex());
+}
+
+/**
+ * @brief Add type and parameters of material to fingerprint.
+ * @param fingerprint Fingerprint.
+ * @param material Material.
+ */
+void AddMaterial(Fingerprint& fingerprint, const DiffuseLight& material)
+    noexcept {
+    fingerprint.Add('E');
+    fingerprint.Add(material.GetRadiance());
+}
+
+/**
+ * @brief Add type and parameters of material of unknown type to
+ * fingerprint.
+ *
+ * Throws std::invalid_argument for materials it does not know, since
+ * checkpoint could not tell them apart.
+ * @param fingerprint Fingerprint.
+ * @param material Material.
+ */
+void AddMaterial(Fingerprint& fingerprint, const Material& material) {
+    if(const auto lambertian = dynamic_cast<const Lambertian*>(&material))
+        AddMaterial(fingerprint, *lambertian);
+    else if(const auto metal = dynamic_cast<const Metal*>(&material))
+        AddMaterial(fingerprint, *metal);
+    else if(const auto dielectric = dynamic_cast<const Dielectric*>(
+        &material))
+        AddMaterial(fingerprint, *dielectric);
+    else if(const auto light = dynamic_cast<const DiffuseLight*>(&material))
+        AddMaterial(fingerprint, *light);
+    else
+        throw std::invalid_argument("Checkpoint does not support material");
+}
+
+/**
+ * @brief Add flat scene to fingerprint: spheres, indices of their materials
+ * and types and parameters of these.
+ * @param fingerprint Fingerprint.
+ * @param scene Scene.
+ */
+void AddScene(Fingerprint& fingerprint, const Scene& scene) noexcept {
+    const auto& spheres = scene.GetSpheres();
+    for(const auto* array : {&spheres.x, &spheres.y, &spheres.z,
+        &spheres.radius})
+        fingerprint.Add(std::span<const float>(*array));
+    fingerprint.Add(std::span<const std::uint32_t>(spheres.material));
+    for(const auto& material : scene.GetMaterials())
+        std::visit([&](const auto& value) {
+            AddMaterial(fingerprint, value);
+        }, material);
+}
+
+/**
+ * @brief Add scene of objects to fingerprint, descending into containers:
+ * spheres, their materials and numbers of children of containers.
+ *
+ * Throws std::invalid_argument for objects and materials it does not know,
+ * since checkpoint could not tell them apart.
+ * @param fingerprint Fingerprint.
+ * @param scene Scene.
+ */
+void AddScene(Fingerprint& fingerprint, const Object& scene) {
+    const auto AddChildren = [&](const auto& children) {
+        fingerprint.Add(children.size());
+        for(const auto& child : children)
+            AddScene(fingerprint, *child);
+    };
+    if(const auto sphere = dynamic_cast<const Sphere*>(&scene)) {
+        fingerprint.Add(sphere->GetCenter());
+        fingerprint.Add(sphere->GetRadius());
+        AddMaterial(fingerprint, *sphere->GetMaterial());
+    } else if(const auto objects = dynamic_cast<const Objects*>(&scene)) {
+        AddChildren(objects->GetObjects());
+    } else if(const auto bvh = dynamic_cast<const BVH*>(&scene)) {
+        AddChildren(bvh->GetObjects());
+    } else {
+        throw std::invalid_argument("Checkpoint does not support object");
+    }
+}
+
+/**
+ * @brief Get header of checkpoint file, identifying image it resumes.
+ * @param width Width.
+ * @param height Height.
+ * @param fingerprint Fingerprint of scene, camera and sampling.
+ */
+auto CheckpointHeader(const int width, const int height,
+    const std::uint64_t fingerprint) noexcept -> std::array<std::uint32_t, 7> {
+    std::array<std::uint32_t, 7> header;
+    std::memcpy(header.data(), CHECKPOINT_MAGIC.data(),
+        CHECKPOINT_MAGIC.size());
+    header[2] = static_cast<std::uint32_t>(width);
+    header[3] = static_cast<std::uint32_t>(height);
+    header[4] = sizeof(Sampler);
+    header[5] = static_cast<std::uint32_t>(fingerprint);
+    header[6] = static_cast<std::uint32_t>(fingerprint >> 32);
+    return header;
+}
+
+/**
+ * @brief Save progress to checkpoint file.
+ *
+ * File is written next to it and renamed over it, so killing process never
+ * leaves it half written. Numbers are stored in byte order of machine.
+ * @param progress Progress.
+ * @param width Width.
+ * @param height Height.
+ * @param fingerprint Fingerprint of scene, camera and sampling.
+ */
+void SaveCheckpoint(const Progress& progress, const int width,
+    const int height, const std::uint64_t fingerprint) {
+    const auto temporary = std::string(CHECKPOINT) + ".tmp";
+    std::ofstream file(temporary, std::ios::out | std::ios::binary);
+    const auto Write = [&](const auto& data) {
+        file.write(reinterpret_cast<const char*>(data.data()),
+            static_cast<std::streamsize>(data.size() * sizeof(data[0])));
+    };
+    Write(CheckpointHeader(width, height, fingerprint));
+    Write(progress.sums);
+    Write(progress.samples);
+    Write(progress.samplers);
+    file.close();
+    if(!file)
+        throw std::runtime_error("Failed to write checkpoint file");
+    std::filesystem::rename(temporary, CHECKPOINT);
+}
+
+/**
+ * @brief Load progress from checkpoint file if there is one.
+ *
+ * Throws std::runtime_error if it belongs to other image or is cut short.
+ * @param progress Progress, sized for image.
+ * @param width Width.
+ * @param height Height.
+ * @param fingerprint Fingerprint of scene, camera and sampling.
+ * @return Whether there was checkpoint.
+ */
+auto LoadCheckpoint(Progress& progress, const int width, const int height,
+    const std::uint64_t fingerprint) -> bool {
+    std::ifstream file(CHECKPOINT, std::ios::in | std::ios::binary);
+    if(!file.is_open())
+        return false;
+    const auto Read = [&](auto& data) {
+        file.read(reinterpret_cast<char*>(data.data()),
+            static_cast<std::streamsize>(data.size() * sizeof(data[0])));
+    };
+    std::array<std::uint32_t, 7> header;
+    Read(header);
+    if(!file || header != CheckpointHeader(width, height, fingerprint))
+        throw std::runtime_error("Checkpoint file belongs to other image");
+    Read(progress.sums);
+    Read(progress.samples);
+    Read(progress.samplers);
+    if(!file)
+        throw std::runtime_error("Checkpoint file is cut short");
+    return true;
+}
+
+} // namespace
+
 Camera::Camera(Orientation orientation, Image image, Lens lens,
-    Sampling sampling) :
+    Sampling sampling, Scheduling scheduling) :
     orientation_configuration(orientation), image_configuration(image),
     lens_configuration(lens), sampling_configuration(sampling),
+    scheduling_configuration(scheduling),
     image_height{static_cast<int>(image.image_width / image.aspect_ratio)} {
 
-    file.open("image.ppm", std::ios::out);
+    file.open(ImageName(image.format), std::ios::out | std::ios::binary);
     if(!file.is_open())
         throw std::runtime_error("Failed to open image file for writing");
 
@@ -30,10 +405,11 @@ Camera::Camera(Orientation orientation, Image image, Lens lens,
     const auto viewport_width = viewport_height *
         (static_cast<float>(image.image_width) / image_height);
 
-    const auto w = math::Normalize(orientation_configuration.look_from -
-        orientation_configuration.look_at);
-    const auto u = math::Cross(orientation_configuration.up, w).Normalize();
-    const auto v = math::Cross(w, u);
+    const auto basis = math::LookAtBasis(orientation_configuration.look_from,
+        orientation_configuration.look_at, orientation_configuration.up);
+    const auto& u = basis[0];
+    const auto& v = basis[1];
+    const auto& w = basis[2];
     const auto viewport_u = viewport_width * u;
     const auto viewport_v = viewport_height * -v;
     const auto viewport_up_left = orientation_configuration.look_from -
@@ -57,103 +433,660 @@ Camera::~Camera() noexcept {
 }
 
 void Camera::Render(const Object& scene) {
-    const auto threads_count = std::thread::hardware_concurrency();
-    const auto segment = image_height / threads_count;
+    RenderTiles(scene);
+}
 
-    std::vector<std::thread> threads;
-    threads.resize(threads_count);
+void Camera::Render(const Scene& scene) {
+    RenderTiles(scene);
+}
 
-    std::vector<std::vector<Color>> colors;
-    colors.resize(threads_count);
-    for(auto& color : colors)
-        color.resize(image_configuration.image_width * segment);
+template<typename S>
+void Camera::RenderTiles(const S& scene) {
+    const auto width = image_configuration.image_width;
+    const auto tile_size = std::max(1, scheduling_configuration.tile_size);
+    const auto tiles_x = (width + tile_size - 1) / tile_size;
+    const auto tiles_y = (image_height + tile_size - 1) / tile_size;
+    const auto tiles_count = tiles_x * tiles_y;
+    const auto threads_count = std::max(1, std::min(tiles_count,
+        scheduling_configuration.threads > 0 ?
+        scheduling_configuration.threads :
+        static_cast<int>(std::thread::hardware_concurrency())));
+
+    // Bands of tile rows are rendered into ring of slots and written in order
+    // as they complete, unless image is needed whole
+    const auto progressive = scheduling_configuration.progressive;
+    const auto streaming = scheduling_configuration.streaming &&
+        sampling_configuration.target_error <= 0.0f && !progressive;
+    const auto bands = tiles_y;
+    const auto slots = streaming ? std::min(bands,
+        threads_count / tiles_x + 2) : 1;
+    const auto band_size = static_cast<std::size_t>(width) *
+        (streaming ? tile_size : image_height);
+    std::vector<Color> colors(slots * band_size);
+    std::vector<int> finished(slots, 0);
+    auto written = 0;
+    std::mutex mutex;
+    std::condition_variable condition;
+    Writer writer(file, width, image_height, image_configuration.format);
+
+    std::atomic<std::uint64_t> rays{0};
+    const auto ForEachTile = [&](const auto& function) -> void {
+        std::atomic<int> next_tile{0};
+        const auto Work = [&]() -> void {
+            for(auto tile = next_tile++; tile < tiles_count;
+                tile = next_tile++) {
+                const auto x_start = tile % tiles_x * tile_size;
+                const auto y_start = tile / tiles_x * tile_size;
+                function(x_start, y_start, std::min(x_start + tile_size,
+                    width), std::min(y_start + tile_size, image_height));
+            }
+            rays += traced_rays;
+            traced_rays = 0;
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(threads_count);
+        for(auto i = 0; i < threads_count; ++i)
+            threads.emplace_back(Work);
+        for(auto& thread : threads)
+            thread.join();
+    };
 
-    const auto RenderSegment = [&](const int i,
-        const int y_start, const int y_end) -> void {
+    std::cout << "Ray tracing " << tiles_count << " tiles on " <<
+        threads_count << " threads..." << std::endl;
+    const auto start = std::chrono::steady_clock::now();
+
+    const auto RenderTile = [&](const int x_start, const int y_start,
+        const int x_end, const int y_end, const std::span<Color> rows) {
+        if constexpr(std::same_as<S, Scene>) {
+            if(scheduling_configuration.integrator == Integrator::WAVEFRONT &&
+                sampling_configuration.max_depth > 0) {
+                RenderWavefront(scene, x_start, y_start, x_end, y_end, rows);
+                return;
+            }
+            const auto packet_size = std::min(MAX_PACKET_SIZE,
+                scheduling_configuration.packet_size);
+            if(packet_size > 1 && sampling_configuration.max_depth > 0) {
+                for(auto y = y_start; y < y_end; y += packet_size)
+                    for(auto x = x_start; x < x_end; x += packet_size)
+                        RenderPacket(scene, x, y,
+                            std::min(x + packet_size, x_end),
+                            std::min(y + packet_size, y_end), rows.subspan(
+                            static_cast<std::size_t>(y - y_start) * width));
+                return;
+            }
+        }
         for(const auto& y : std::ranges::views::iota(y_start, y_end)) {
-            for(const auto& x :
-                std::ranges::views::iota(0, image_configuration.image_width)) {
+            for(const auto& x : std::ranges::views::iota(x_start, x_end)) {
+                Sampler::SetSampler(GetSampler(x, y));
                 Color color{0.0f, 0.0f, 0.0f};
-                for([[maybe_unused]] const auto& sample :
-                    std::ranges::views::iota(
-                        0, sampling_configuration.samples)) {
+                for(const auto& sample : std::ranges::views::iota(
+                    0, sampling_configuration.samples)) {
+                    Sampler::Start(static_cast<std::uint32_t>(sample));
                     const auto ray = GetRay(x, y);
-                    color += TraceRay(ray, scene,
-                        sampling_configuration.max_depth);
+                    color += TraceRay(ray, scene);
                 }
-                colors[i][(y - y_start) * image_configuration.image_width + x] =
+                rows[static_cast<std::size_t>(y - y_start) * width + x] =
                     pixel_sample_weight * color;
             }
         }
     };
 
-    std::cout << "Ray tracing on " << threads_count << " threads..." <<
-        std::endl;
+    if(progressive) {
+        RenderProgressive(scene, ForEachTile, colors);
+    } else if(sampling_configuration.target_error > 0.0f) {
+        RenderAdaptive(scene, ForEachTile, colors);
+        writer.Append(colors);
+    } else if(!streaming) {
+        ForEachTile([&](const int x_start, const int y_start, const int x_end,
+            const int y_end) {
+            RenderTile(x_start, y_start, x_end, y_end, std::span(colors)
+                .subspan(static_cast<std::size_t>(y_start) * width));
+        });
+        writer.Append(colors);
+    } else {
+        // Tiles are taken in order, so band being written next is always
+        // rendering and threads wait only while all slots are ahead of it
+        ForEachTile([&](const int x_start, const int y_start, const int x_end,
+            const int y_end) {
+            const auto band = y_start / tile_size;
+            const auto slot = static_cast<std::size_t>(band % slots);
+            {
+                std::unique_lock lock(mutex);
+                condition.wait(lock, [&] { return band < written + slots; });
+            }
+            const auto rows = std::span(colors).subspan(slot * band_size,
+                band_size);
+            RenderTile(x_start, y_start, x_end, y_end, rows);
 
-    for(auto i = 0u; i < threads_count; ++i) {
-        const auto y_start = i * segment;
-        const auto y_end = (i + 1u) * segment;
-        if(i == threads_count - 1u)
-            threads[i] = std::thread(RenderSegment, i, y_start, image_height);
-        else
-            threads[i] = std::thread(RenderSegment, i, y_start, y_end);
+            std::lock_guard lock(mutex);
+            if(++finished[slot] < tiles_x)
+                return;
+            while(written < bands && finished[written % slots] == tiles_x) {
+                finished[written % slots] = 0;
+                writer.Append(std::span(colors).subspan(
+                    static_cast<std::size_t>(written % slots) * band_size,
+                    static_cast<std::size_t>(std::min(tile_size,
+                    image_height - written * tile_size)) * width));
+                ++written;
+            }
+            condition.notify_all();
+        });
     }
-    for(auto& thread : threads)
-        thread.join();
+    if(!progressive)
+        writer.Finish();
+    const auto seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Traced " << rays << " rays in " << seconds << " s, " <<
+        rays / seconds * 1e-6 << " Mrays/s" << std::endl;
 
-    file << "P3\n" << image_configuration.image_width << ' ' <<
-        image_height << "\n255\n";
-    for(const auto& color : colors)
-        for(const auto& pixel : color)
-            WriteColor(pixel);
     std::cout << "Done!" << std::endl;
 }
 
+template<typename S, typename F>
+void Camera::RenderAdaptive(const S& scene, const F& for_each_tile,
+    std::vector<Color>& colors) const {
+    const auto width = image_configuration.image_width;
+    const auto count = colors.size();
+    std::vector<Sampler> samplers(count);
+    std::vector<Color> sums(count, Color{0.0f, 0.0f, 0.0f});
+    std::vector<float> means(count, 0.0f);
+    std::vector<float> squares(count, 0.0f);
+    std::vector<int> samples(count, 0);
+    std::vector<int> assigned(count,
+        std::max(2, sampling_configuration.min_samples));
+    for(std::size_t pixel = 0; pixel < count; ++pixel)
+        samplers[pixel] = GetSampler(static_cast<int>(pixel % width),
+            static_cast<int>(pixel / width));
+
+    // Standard deviation of brightness after gamma correction, at least that
+    // of neighbors, since few samples can all miss rare bright paths
+    std::vector<float> deviations(count);
+    const auto Deviation = [&](const std::size_t pixel) noexcept {
+        const auto x = static_cast<int>(pixel % width);
+        const auto y = static_cast<int>(pixel / width);
+        auto deviation = 0.0f;
+        for(auto j = std::max(0, y - 1); j <= std::min(y + 1,
+            image_height - 1); ++j)
+            for(auto i = std::max(0, x - 1); i <= std::min(x + 1, width - 1);
+                ++i)
+                deviation = std::max(deviation, deviations[
+                    static_cast<std::size_t>(j) * width + i]);
+        return deviation;
+    };
+
+    const auto budget = static_cast<std::uint64_t>(
+        std::max(0, sampling_configuration.samples)) * count;
+    std::uint64_t used{0};
+    std::vector<std::pair<float, std::uint32_t>> noisy;
+    auto passes = 0;
+    while(true) {
+        for_each_tile([&](const int x_start, const int y_start,
+            const int x_end, const int y_end) {
+            for(auto y = y_start; y < y_end; ++y) {
+                for(auto x = x_start; x < x_end; ++x) {
+                    const auto pixel = static_cast<std::size_t>(y) * width +
+                        x;
+                    if(assigned[pixel] == 0)
+                        continue;
+                    Sampler::SetSampler(samplers[pixel]);
+                    for(auto i = 0; i < assigned[pixel]; ++i) {
+                        Sampler::Start(static_cast<std::uint32_t>(
+                            samples[pixel]));
+                        const auto color = TraceRay(GetRay(x, y), scene);
+                        const auto luminance = 0.2126f * color[0] +
+                            0.7152f * color[1] + 0.0722f * color[2];
+                        const auto delta = luminance - means[pixel];
+                        sums[pixel] += color;
+                        means[pixel] += delta / ++samples[pixel];
+                        squares[pixel] += delta * (luminance - means[pixel]);
+                    }
+                    samplers[pixel] = Sampler::GetSampler();
+                }
+            }
+        });
+        ++passes;
+        for(const auto& n : assigned)
+            used += n;
+
+        for(std::size_t pixel = 0; pixel < count; ++pixel)
+            deviations[pixel] = Math::Sqrt(squares[pixel] /
+                (samples[pixel] - 1)) / (2.0f * Math::Sqrt(std::max(
+                means[pixel], 1e-4f)));
+        noisy.clear();
+        auto sum = 0.0f;
+        auto pool = budget - std::min(used, budget);
+        for(std::uint32_t pixel = 0; pixel < count; ++pixel) {
+            const auto deviation = Deviation(pixel);
+            if(deviation > sampling_configuration.target_error *
+                Math::Sqrt(static_cast<float>(samples[pixel]))) {
+                noisy.emplace_back(deviation, pixel);
+                sum += deviation;
+                pool += samples[pixel];
+            }
+        }
+        if(noisy.empty() || used >= budget)
+            break;
+
+        // Share samples left and those of noisy pixels in proportion to
+        // deviations, which minimizes squared error, at most doubling samples
+        // of pixel before estimating again, noisiest first
+        std::ranges::sort(noisy, std::greater{});
+        auto remaining = budget - used;
+        std::ranges::fill(assigned, 0);
+        for(const auto& [deviation, pixel] : noisy) {
+            const auto share = static_cast<int>(static_cast<float>(pool) *
+                deviation / sum);
+            assigned[pixel] = static_cast<int>(std::min<std::uint64_t>(
+                std::clamp(share - samples[pixel], 0, samples[pixel]),
+                remaining));
+            remaining -= assigned[pixel];
+        }
+        if(remaining == budget - used)
+            break;
+    }
+
+    auto most = 0;
+    for(std::size_t pixel = 0; pixel < count; ++pixel) {
+        colors[pixel] = (1.0f / samples[pixel]) * sums[pixel];
+        most = std::max(most, samples[pixel]);
+    }
+    std::cout << "Sampled adaptively in " << passes << " passes, " <<
+        static_cast<double>(used) / count << " samples per pixel on average, "
+        << most << " at most, " << noisy.size() << " pixels above target" <<
+        std::endl;
+
+    std::ofstream heatmap("samples.ppm", std::ios::out | std::ios::binary);
+    if(!heatmap.is_open())
+        throw std::runtime_error("Failed to open heatmap file for writing");
+    std::vector<std::uint8_t> bytes(3 * count);
+    for(std::size_t pixel = 0; pixel < count; ++pixel) {
+        const auto heat = 3.0f * samples[pixel] / most;
+        for(auto channel = 0; channel < 3; ++channel)
+            bytes[3 * pixel + channel] = static_cast<std::uint8_t>(255.0f *
+                std::clamp(heat - channel, 0.0f, 1.0f));
+    }
+    Writer::Write(heatmap, bytes, width, image_height, Writer::Format::PPM);
+}
+
+template<typename S, typename F>
+void Camera::RenderProgressive(const S& scene, const F& for_each_tile,
+    std::vector<Color>& colors) {
+    const auto width = image_configuration.image_width;
+    const auto count = colors.size();
+    const auto target = static_cast<std::uint32_t>(
+        std::max(0, sampling_configuration.samples));
+
+    // Target samples are left out, so that run with more goes on
+    Fingerprint fingerprint;
+    AddScene(fingerprint, scene);
+    for(const auto& vector : {orientation_configuration.look_from,
+        orientation_configuration.look_at, orientation_configuration.up})
+        fingerprint.Add(vector);
+    fingerprint.Add(image_configuration.aspect_ratio);
+    fingerprint.Add(lens_configuration.vertical_fov);
+    fingerprint.Add(lens_configuration.defocus_angle);
+    fingerprint.Add(lens_configuration.focus_distance);
+    fingerprint.Add(sampling_configuration.max_depth);
+    fingerprint.Add(sampling_configuration.roulette_depth);
+    fingerprint.Add(sampling_configuration.sampler);
+
+    Progress progress{std::vector<Color>(count, Color{0.0f, 0.0f, 0.0f}),
+        std::vector<std::uint32_t>(count, 0), std::vector<Sampler>(count)};
+    if(LoadCheckpoint(progress, width, image_height, fingerprint.Get())) {
+        std::cout << "Resumed from checkpoint at " <<
+            std::ranges::min(progress.samples) << " samples per pixel" <<
+            std::endl;
+    } else {
+        for(std::size_t pixel = 0; pixel < count; ++pixel)
+            progress.samplers[pixel] = GetSampler(
+                static_cast<int>(pixel % width),
+                static_cast<int>(pixel / width));
+    }
+
+    const auto WriteImage = [&] {
+        for(std::size_t pixel = 0; pixel < count; ++pixel)
+            colors[pixel] = progress.samples[pixel] > 0 ?
+                (1.0f / progress.samples[pixel]) * progress.sums[pixel] :
+                Color{0.0f, 0.0f, 0.0f};
+        file.close();
+        file.open(ImageName(image_configuration.format),
+            std::ios::out | std::ios::binary);
+        Writer::Write(file, colors, width, image_height,
+            image_configuration.format);
+    };
+
+    const auto interval = std::chrono::duration<double>(
+        scheduling_configuration.checkpoint_interval);
+    auto last = std::chrono::steady_clock::now();
+    auto passes = 0;
+    while(std::ranges::any_of(progress.samples,
+        [&](const std::uint32_t n) { return n < target; })) {
+        for_each_tile([&](const int x_start, const int y_start,
+            const int x_end, const int y_end) {
+            for(auto y = y_start; y < y_end; ++y) {
+                for(auto x = x_start; x < x_end; ++x) {
+                    const auto pixel = static_cast<std::size_t>(y) * width +
+                        x;
+                    auto& samples = progress.samples[pixel];
+                    if(samples >= target)
+                        continue;
+                    Sampler::SetSampler(progress.samplers[pixel]);
+                    Sampler::Start(samples++);
+                    progress.sums[pixel] += TraceRay(GetRay(x, y), scene);
+                    progress.samplers[pixel] = Sampler::GetSampler();
+                }
+            }
+        });
+        ++passes;
+        const auto now = std::chrono::steady_clock::now();
+        if(now - last >= interval) {
+            SaveCheckpoint(progress, width, image_height, fingerprint.Get());
+            WriteImage();
+            last = now;
+        }
+    }
+    WriteImage();
+    std::filesystem::remove(CHECKPOINT);
+    std::cout << "Rendered " << passes << " passes progressively" <<
+        std::endl;
+}
+
+void Camera::RenderPacket(const Scene& scene, const int x_start,
+    const int y_start, const int x_end, const int y_end,
+    const std::span<Color> rows) const {
+    const auto width = image_configuration.image_width;
+    std::array<Sampler, Scene::PACKET_SIZE> samplers;
+    std::array<Color, Scene::PACKET_SIZE> sums;
+    std::array<Ray, Scene::PACKET_SIZE> rays;
+    std::array<std::optional<Scene::Hit>, Scene::PACKET_SIZE> hits;
+    const auto count = static_cast<std::size_t>((x_end - x_start) *
+        (y_end - y_start));
+    const auto ForEachPixel = [&](const auto function) {
+        auto i = std::size_t{0};
+        for(auto y = y_start; y < y_end; ++y)
+            for(auto x = x_start; x < x_end; ++x)
+                function(i++, x, y);
+    };
+
+    ForEachPixel([&](const std::size_t i, const int x, const int y) {
+        samplers[i] = GetSampler(x, y);
+        sums[i] = Color{0.0f, 0.0f, 0.0f};
+    });
+    for(const auto& sample :
+        std::ranges::views::iota(0, sampling_configuration.samples)) {
+        ForEachPixel([&](const std::size_t i, const int x, const int y) {
+            Sampler::SetSampler(samplers[i]);
+            Sampler::Start(static_cast<std::uint32_t>(sample));
+            rays[i] = GetRay(x, y);
+            samplers[i] = Sampler::GetSampler();
+        });
+        scene.CheckHits(std::span(rays.data(), count), Interval{1e-4f,
+            std::numeric_limits<float>::infinity()},
+            std::span(hits.data(), count));
+        traced_rays += count;
+        ForEachPixel([&](const std::size_t i, int, int) {
+            Sampler::SetSampler(samplers[i]);
+            sums[i] += TracePath(rays[i], hits[i], scene);
+            samplers[i] = Sampler::GetSampler();
+        });
+    }
+    ForEachPixel([&](const std::size_t i, const int x, const int y) {
+        rows[static_cast<std::size_t>(y - y_start) * width + x] =
+            pixel_sample_weight * sums[i];
+    });
+}
+
+void Camera::RenderWavefront(const Scene& scene, const int x_start,
+    const int y_start, const int x_end, const int y_end,
+    const std::span<Color> rows) const {
+    thread_local Wavefront wavefront;
+    auto& [samplers, sums, samples, idle, paths, survivors, hits, buckets] =
+        wavefront;
+    const auto width = image_configuration.image_width;
+    const auto block_width = x_end - x_start;
+    const auto count = static_cast<std::size_t>(block_width *
+        (y_end - y_start));
+    const auto interval = Interval{1e-4f,
+        std::numeric_limits<float>::infinity()};
+    const auto& materials = scene.GetMaterials();
+    const auto lit = !scene.GetLights().empty();
+    const auto Column = [&](const std::uint32_t pixel) noexcept {
+        return x_start + static_cast<int>(pixel) % block_width;
+    };
+    const auto Row = [&](const std::uint32_t pixel) noexcept {
+        return y_start + static_cast<int>(pixel) / block_width;
+    };
+
+    samplers.resize(count);
+    sums.assign(count, Color{0.0f, 0.0f, 0.0f});
+    samples.assign(count, sampling_configuration.samples);
+    idle.resize(count);
+    std::iota(idle.begin(), idle.end(), std::uint32_t{0});
+    for(const auto& pixel : idle)
+        samplers[pixel] = GetSampler(Column(pixel), Row(pixel));
+    paths.Clear();
+
+    while(true) {
+        // Generate, neighboring pixels next to each other for packets
+        const auto continuing = paths.Size();
+        std::ranges::sort(idle);
+        for(const auto& pixel : idle) {
+            if(samples[pixel] == 0)
+                continue;
+            Sampler::SetSampler(samplers[pixel]);
+            Sampler::Start(static_cast<std::uint32_t>(
+                sampling_configuration.samples - samples[pixel]--));
+            paths.Push(GetRay(Column(pixel), Row(pixel)),
+                Color{1.0f, 1.0f, 1.0f}, Color{0.0f, 0.0f, 0.0f}, 0.0f, pixel,
+                1);
+            samplers[pixel] = Sampler::GetSampler();
+        }
+        idle.clear();
+        if(paths.Size() == 0)
+            break;
+
+        // Intersect, fresh rays in packets
+        hits.resize(paths.Size());
+        const auto packets = scheduling_configuration.packet_size > 1;
+        const auto single = packets ? continuing : paths.Size();
+        for(std::size_t i = 0; i < single; ++i)
+            hits[i] = scene.CheckHit(paths.rays[i], interval);
+        if(single < paths.Size())
+            scene.CheckHits(std::span(paths.rays).subspan(single), interval,
+                std::span(hits).subspan(single));
+        traced_rays += paths.Size();
+
+        // Sort by material type
+        for(auto& bucket : buckets)
+            bucket.clear();
+        for(std::uint32_t i = 0; i < paths.Size(); ++i)
+            buckets[hits[i] ? 1 + materials[hits[i]->material].index() : 0]
+                .push_back(i);
+
+        // Shade, compacting survivors
+        survivors.Clear();
+        for(const auto& i : buckets[0]) {
+            const auto pixel = paths.pixels[i];
+            sums[pixel] += paths.radiances[i] + paths.throughputs[i] *
+                Sky(paths.rays[i]);
+            idle.push_back(pixel);
+        }
+        [&]<std::size_t... T>(std::index_sequence<T...>) {
+            ([&] {
+                for(const auto& i : buckets[1 + T]) {
+                    const auto pixel = paths.pixels[i];
+                    const auto& hit = *hits[i];
+                    const auto depth = paths.depths[i];
+                    auto throughput = paths.throughputs[i];
+                    auto radiance = paths.radiances[i];
+                    auto pdf = 0.0f;
+                    Sampler::SetSampler(samplers[pixel]);
+                    if(lit) {
+                        radiance += throughput * Emission(scene, paths.rays[i],
+                            hit, paths.pdfs[i]);
+                        if(depth < sampling_configuration.max_depth)
+                            radiance += throughput * SampleLight(scene,
+                                paths.rays[i], hit);
+                    }
+                    const auto scatter = std::get<T>(materials[hit.material])
+                        .Scatter(paths.rays[i], hit.surface);
+                    auto survives = scatter &&
+                        depth < sampling_configuration.max_depth;
+                    if(survives) {
+                        if(lit)
+                            pdf = ScatterPdf(scene, paths.rays[i], hit,
+                                scatter->second);
+                        throughput *= scatter->first;
+                        survives = Survives(throughput, depth);
+                    }
+                    samplers[pixel] = Sampler::GetSampler();
+                    if(survives) {
+                        survivors.Push(scatter->second, throughput, radiance,
+                            pdf, pixel, depth + 1);
+                    } else {
+                        sums[pixel] += radiance;
+                        idle.push_back(pixel);
+                    }
+                }
+            }(), ...);
+        }(std::make_index_sequence<MATERIAL_TYPES>{});
+        std::swap(paths, survivors);
+    }
+
+    for(std::uint32_t pixel = 0; pixel < count; ++pixel)
+        rows[static_cast<std::size_t>(Row(pixel) - y_start) * width +
+            Column(pixel)] = pixel_sample_weight * sums[pixel];
+}
+
+auto Camera::GetSampler(const int x, const int y) const noexcept
+    -> Sampler {
+    return Sampler(sampling_configuration.sampler,
+        static_cast<std::uint32_t>(std::max(1,
+        sampling_configuration.samples)), static_cast<std::uint32_t>(x),
+        static_cast<std::uint32_t>(y), static_cast<std::uint64_t>(y) *
+        image_configuration.image_width + x);
+}
+
 auto Camera::GetRay(const int x, const int y) const noexcept -> Ray {
-    const auto offset = std::make_pair(Random::Number<float>() - 0.5f,
-        Random::Number<float>() - 0.5f);
-    const auto pixel_sample = pixel_up_left +
-        (x + offset.first) * pixel_delta_u +
-        (y + offset.second) * pixel_delta_v;
-    const auto point = Random::VectorUnitDisk<float, 3>();
-    const auto origin = orientation_configuration.look_from +
-        point[0] * defocus_disk_delta_u + point[1] * defocus_disk_delta_v;
+    const auto [u, v] = Sampler::Get2D();
+    const Vector3f pixel_sample = math::Lazy(pixel_up_left) +
+        (x + u - 0.5f) * math::Lazy(pixel_delta_u) +
+        (y + v - 0.5f) * math::Lazy(pixel_delta_v);
+    const auto point = warp::Disk(Sampler::Get2D());
+    const Vector3f origin = math::Lazy(orientation_configuration.look_from) +
+        point[0] * math::Lazy(defocus_disk_delta_u) +
+        point[1] * math::Lazy(defocus_disk_delta_v);
     return Ray(origin, pixel_sample - origin);
 }
 
-auto Camera::TraceRay(const Ray& ray, const Object& scene, const int depth)
-    const -> Color {
-    if(depth <= 0)
+template<typename S>
+auto Camera::TraceRay(const Ray& ray, const S& scene) const -> Color {
+    if(sampling_configuration.max_depth <= 0)
         return Color{0.0f, 0.0f, 0.0f};
+    ++traced_rays;
+    return TracePath(ray, scene.CheckHit(ray, Interval{1e-4f,
+        std::numeric_limits<float>::infinity()}), scene);
+}
 
-    if(const auto hit = scene.CheckHit(ray, Interval{1e-4f,
-        std::numeric_limits<float>::infinity()})) {
-        if(const auto scatter = hit->material->Scatter(ray, *hit)) {
-            const auto [attenuation, scattered] = *scatter;
-            return attenuation * TraceRay(scattered, scene, depth - 1);
+template<typename S, typename H>
+auto Camera::TracePath(Ray ray, std::optional<H> hit, const S& scene) const
+    -> Color {
+    Color throughput{1.0f, 1.0f, 1.0f};
+    Color radiance{0.0f, 0.0f, 0.0f};
+    auto pdf = 0.0f;
+    const auto lit = [&] {
+        if constexpr(std::same_as<S, Scene>)
+            return !scene.GetLights().empty();
+        else
+            return false;
+    }();
+    for(auto depth = 1; hit; ++depth) {
+        if constexpr(std::same_as<S, Scene>) {
+            if(lit) {
+                radiance += throughput * Emission(scene, ray, *hit, pdf);
+                if(depth < sampling_configuration.max_depth)
+                    radiance += throughput * SampleLight(scene, ray, *hit);
+            }
+        } else {
+            radiance += throughput * hit->material->Emitted(*hit);
         }
-        return Color{0.0f, 0.0f, 0.0f};
+        const auto scatter = [&] {
+            if constexpr(std::same_as<S, Scene>)
+                return scene.Scatter(ray, *hit);
+            else
+                return hit->material->Scatter(ray, *hit);
+        }();
+        if(!scatter || depth >= sampling_configuration.max_depth)
+            return radiance;
+        if constexpr(std::same_as<S, Scene>)
+            if(lit)
+                pdf = ScatterPdf(scene, ray, *hit, scatter->second);
+        throughput *= scatter->first;
+        ray = scatter->second;
+        if(!Survives(throughput, depth))
+            return radiance;
+        ++traced_rays;
+        hit = scene.CheckHit(ray, Interval{1e-4f,
+            std::numeric_limits<float>::infinity()});
     }
+    return radiance + throughput * Sky(ray);
+}
 
-    const auto gradient = 0.5f * (ray.Direction().Normalize()[1] + 1.0f);
-    return (1.0f - gradient) * Color{1.0f, 1.0f, 1.0f} +
-        gradient * Color{0.5f, 0.7f, 1.0f};
+auto Camera::Emission(const Scene& scene, const Ray& ray,
+    const Scene::Hit& hit, const float pdf) noexcept -> Color {
+    const auto emitted = scene.Emitted(hit);
+    if(pdf <= 0.0f)
+        return emitted;
+    const auto light = scene.LightPdf(ray.Origin(), hit);
+    return pdf * pdf / (pdf * pdf + light * light) * emitted;
 }
 
-void Camera::WriteColor(const Color& color) noexcept {
-    const auto GammaCorrect = [](const float value) noexcept {
-        if(value > 0.0f)
-            return std::sqrt(value);
-        return 0.0f;
-    };
+auto Camera::SampleLight(const Scene& scene, const Ray& ray,
+    const Scene::Hit& hit) -> Color {
+    const auto select = Sampler::Get1D();
+    const auto sample = scene.SampleLight(hit.surface.point, select,
+        Sampler::Get2D());
+    if(!sample)
+        return Color{0.0f, 0.0f, 0.0f};
+    const auto scattering = scene.Evaluate(ray, hit, sample->direction);
+    if(!scattering || scattering->second <= 0.0f)
+        return Color{0.0f, 0.0f, 0.0f};
+    ++traced_rays;
+    const auto shadow = scene.CheckHit(Ray(hit.surface.point,
+        sample->direction), Interval{1e-4f,
+        std::numeric_limits<float>::infinity()});
+    if(!shadow || shadow->sphere != sample->sphere)
+        return Color{0.0f, 0.0f, 0.0f};
+    const auto& [color, pdf] = *scattering;
+    const auto light = sample->pdf;
+    return light / (light * light + pdf * pdf) * color *
+        scene.Emitted(*shadow);
+}
+
+auto Camera::ScatterPdf(const Scene& scene, const Ray& ray,
+    const Scene::Hit& hit, const Ray& scattered) noexcept -> float {
+    const auto scattering = scene.Evaluate(ray, hit,
+        Math::Normalize(scattered.Direction()));
+    return scattering ? scattering->second : 0.0f;
+}
+
+auto Camera::Survives(Color& throughput, const int depth) const -> bool {
+    if(depth < sampling_configuration.roulette_depth)
+        return true;
+    const auto probability = std::min(1.0f,
+        std::max({throughput[0], throughput[1], throughput[2]}));
+    if(probability < 1.0f && !(Sampler::Get1D() < probability))
+        return false;
+    throughput /= probability;
+    return true;
+}
 
-    static const auto intensity = Interval{0.0f, 1.0f - 1e-4f};
-    const auto r = GammaCorrect(color[0]);
-    const auto g = GammaCorrect(color[1]);
-    const auto b = GammaCorrect(color[2]);
-    file << static_cast<int>(255.999f * intensity.Clamp(r)) << ' ' <<
-        static_cast<int>(255.999f * intensity.Clamp(g)) << ' ' <<
-        static_cast<int>(255.999f * intensity.Clamp(b)) << '\n';
+auto Camera::Sky(const Ray& ray) noexcept -> Color {
+    constexpr Color horizon{1.0f, 1.0f, 1.0f};
+    constexpr Color zenith{0.5f, 0.7f, 1.0f};
+    const auto gradient = 0.5f * (Math::Normalize(ray.Direction())[1] +
+        1.0f);
+    return (1.0f - gradient) * horizon + gradient * zenith;
 }
 
 } // namespace ray
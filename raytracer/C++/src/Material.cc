@@ -1,35 +1,67 @@
 module;
 
+#include <algorithm>
+#include <numbers>
 #include <optional>
 
 #include <cmath>
 
-import Random;
+import Approx;
+import Sampler;
 
 module Material;
 
 namespace ray {
 
-auto Lambertian::Scatter([[maybe_unused]] const Ray& ray, const Hit& hit)
+auto Lambertian::Scatter([[maybe_unused]] const Ray& ray, const Surface& hit)
     const -> std::optional<std::pair<Color, Ray>> {
-    auto direction = hit.normal + Random::VectorUnitSphere<float, 3>();
+    auto direction = warp::CosineHemisphere(hit.normal, Sampler::Get2D());
     if(std::abs(direction[0]) < 1e-8f && std::abs(direction[1]) < 1e-8f &&
             std::abs(direction[2]) < 1e-8f)
         direction = hit.normal;
     return std::make_pair(albedo, Ray(hit.point, direction));
 }
 
-auto Metal::Scatter(const Ray& ray, const Hit& hit) const ->
+auto Lambertian::Evaluate([[maybe_unused]] const Ray& ray,
+    const Surface& hit, const Vector3f& direction) const noexcept
+    -> std::optional<std::pair<Color, float>> {
+    const auto pdf = std::max(0.0f, hit.normal.Dot(direction)) *
+        std::numbers::inv_pi_v<float>;
+    return std::make_pair(pdf * albedo, pdf);
+}
+
+auto Metal::Scatter(const Ray& ray, const Surface& hit) const ->
     std::optional<std::pair<Color, Ray>> {
     auto direction = ray.Direction().Reflect(hit.normal);
-    direction = direction.Normalize() +
-        fuzziness * Random::VectorUnitSphere<float, 3>();
+    direction = Math::Normalize(direction) +
+        fuzziness * warp::Sphere(Sampler::Get2D());
     const auto result = Ray(hit.point, direction);
     if(result.Direction().Dot(hit.normal) > 0.0f)
         return std::make_pair(albedo, result);
     return std::nullopt;
 }
 
+auto Metal::Evaluate(const Ray& ray, const Surface& hit,
+    const Vector3f& direction) const noexcept
+    -> std::optional<std::pair<Color, float>> {
+    if(fuzziness <= 0.0f)
+        return std::nullopt;
+    if(direction.Dot(hit.normal) <= 0.0f)
+        return std::make_pair(Color{0.0f, 0.0f, 0.0f}, 0.0f);
+    // Direction crosses sphere about unit reflection twice, where distances
+    // t solve t^2 - 2 b t + 1 - fuzziness^2 = 0, and density of each is its
+    // squared distance over area of sphere and cosine of crossing
+    const auto b = direction.Dot(Math::Normalize(ray.Direction().Reflect(
+        hit.normal)));
+    const auto discriminant = b * b - (1.0f - fuzziness * fuzziness);
+    if(b <= 0.0f || discriminant <= 0.0f)
+        return std::make_pair(Color{0.0f, 0.0f, 0.0f}, 0.0f);
+    const auto pdf = (2.0f * b * b - 1.0f + fuzziness * fuzziness) /
+        (2.0f * std::numbers::pi_v<float> * fuzziness *
+        std::sqrt(discriminant));
+    return std::make_pair(pdf * albedo, pdf);
+}
+
 /**
  * @brief Calculate material reflectance.
  * @param cos_theta Cosine of angle.
@@ -39,19 +71,19 @@ auto Metal::Scatter(const Ray& ray, const Hit& hit) const ->
 auto Reflectance(const float cos_theta, const float index) -> float {
     auto r0 = (1.0f - index) / (1.0f + index);
     r0 *= r0;
-    return r0 + (1.0f - r0) * std::pow(1.0f - cos_theta, 5);
+    return r0 + (1.0f - r0) * math::Pow<5>(1.0f - cos_theta);
 }
 
-auto Dielectric::Scatter(const Ray& ray, const Hit& hit) const ->
+auto Dielectric::Scatter(const Ray& ray, const Surface& hit) const ->
     std::optional<std::pair<Color, Ray>> {
     const auto index = hit.front_face ?
         1.0f / refraction_index : refraction_index;
-    const auto direction = ray.Direction().Normalize();
+    const auto direction = Math::Normalize(ray.Direction());
     const auto cos_theta = std::min(-direction.Dot(hit.normal), 1.0f);
-    const auto sin_theta = std::sqrt(1.0f - cos_theta * cos_theta);
+    const auto sin_theta = Math::Sqrt(1.0f - cos_theta * cos_theta);
 
     if(index * sin_theta > 1.0f ||
-        Reflectance(cos_theta, index) > Random::Number<float>())
+        Reflectance(cos_theta, index) > Sampler::Get1D())
         return std::make_pair(Color{1.0f, 1.0f, 1.0f},
             Ray(hit.point, direction.Reflect(hit.normal)));
     else
@@ -1,5 +1,6 @@
 module;
 
+#include <limits>
 #include <optional>
 
 #include <cmath>
@@ -22,8 +23,15 @@ auto Objects::CheckHit(const Ray& ray, const Interval interval) const ->
     return is_hit ? std::make_optional(hit) : std::nullopt;
 }
 
-auto Sphere::CheckHit(const Ray& ray, const Interval interval) const ->
-    std::optional<Hit> {
+auto Objects::BoundingBox() const -> AABB3f {
+    AABB3f box;
+    for(const auto& object : objects)
+        box = box.Union(object->BoundingBox());
+    return box;
+}
+
+auto Sphere::Distance(const Vector3f& center, const float radius,
+    const Ray& ray, const Interval interval) noexcept -> float {
     const auto origin_center = center - ray.Origin();
     const auto a = ray.Direction().Length2();
     const auto b = origin_center.Dot(ray.Direction());
@@ -31,28 +39,36 @@ auto Sphere::CheckHit(const Ray& ray, const Interval interval) const ->
     const auto discriminant = b * b - a * c;
 
     if(discriminant < 0.0f)
-        return std::nullopt;
+        return std::numeric_limits<float>::infinity();
     const auto square_root = std::sqrt(discriminant);
     auto distance = (b - square_root) / a;
     if(!interval.Surrounds(distance)) {
         distance = (b + square_root) / a;
         if(!interval.Surrounds(distance))
-            return std::nullopt;
+            return std::numeric_limits<float>::infinity();
     }
+    return distance;
+}
 
+auto Sphere::SurfaceAt(const Vector3f& center, const float radius,
+    const Ray& ray, const float distance) noexcept -> Surface {
     const auto point = ray.PointAt(distance);
     const auto normal = (point - center) / radius;
     const auto front_face = ray.Direction().Dot(normal) < 0.0f;
-
-    Hit hit{
+    return Surface{
         .point = point,
         .normal = front_face ? normal : -normal,
-        .material = material,
         .distance = distance,
         .front_face = front_face
     };
+}
 
-    return std::make_optional(hit);
+auto Sphere::CheckHit(const Ray& ray, const Interval interval) const ->
+    std::optional<Hit> {
+    const auto distance = Distance(center, radius, ray, interval);
+    if(distance == std::numeric_limits<float>::infinity())
+        return std::nullopt;
+    return Hit{SurfaceAt(center, radius, ray, distance), material};
 }
 
 } // namespace ray
@@ -0,0 +1,121 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+import Random;
+
+module Sampler;
+
+namespace ray {
+
+namespace {
+
+/*! @brief Number of cells of blue noise mask. */
+constexpr auto CELLS = Sampler::MASK_SIZE * Sampler::MASK_SIZE;
+
+/*! @brief Spread of Gaussian filter measuring clusters and voids. */
+constexpr auto SIGMA = 1.9f;
+
+/**
+ * @brief Build blue noise mask by void and cluster method, per Ulichney 1993.
+ *
+ * Energy of each cell is sum of toroidal Gaussian filter over cells taken so
+ * far. Initial pattern of tenth of cells is relaxed by moving tightest
+ * cluster into largest void until stable, then cells are ranked by removing
+ * tightest clusters of it and filling largest voids after it. Filling
+ * largest void of taken cells equals taking tightest cluster of free cells,
+ * so one rule covers both halves.
+ */
+auto BuildMask() -> std::array<float, CELLS> {
+    constexpr auto size = static_cast<int>(Sampler::MASK_SIZE);
+    std::array<float, CELLS> filter;
+    for(auto dy = 0; dy < size; ++dy) {
+        for(auto dx = 0; dx < size; ++dx) {
+            const auto x = static_cast<float>(std::min(dx, size - dx));
+            const auto y = static_cast<float>(std::min(dy, size - dy));
+            filter[dy * size + dx] = std::exp(-(x * x + y * y) /
+                (2.0f * SIGMA * SIGMA));
+        }
+    }
+
+    std::vector<bool> taken(CELLS, false);
+    std::vector<float> energy(CELLS, 0.0f);
+    const auto Toggle = [&](const int cell) noexcept {
+        taken[cell] = !taken[cell];
+        const auto sign = taken[cell] ? 1.0f : -1.0f;
+        const auto x = cell % size;
+        const auto y = cell / size;
+        for(auto j = 0; j < size; ++j) {
+            const auto row = (j - y + size) % size * size;
+            for(auto i = 0; i < size; ++i)
+                energy[j * size + i] += sign * filter[row +
+                    (i - x + size) % size];
+        }
+    };
+    const auto Find = [&](const bool cluster) noexcept {
+        auto best = -1;
+        for(auto cell = 0; cell < static_cast<int>(CELLS); ++cell) {
+            if(taken[cell] != cluster)
+                continue;
+            if(best < 0 || (cluster ? energy[cell] > energy[best] :
+                energy[cell] < energy[best]))
+                best = cell;
+        }
+        return best;
+    };
+
+    Philox generator;
+    const auto initial = static_cast<int>(CELLS / 10);
+    for(auto count = 0; count < initial;) {
+        const auto cell = static_cast<int>(generator() % CELLS);
+        if(!taken[cell]) {
+            Toggle(cell);
+            ++count;
+        }
+    }
+    while(true) {
+        const auto cluster = Find(true);
+        Toggle(cluster);
+        const auto void_ = Find(false);
+        Toggle(void_);
+        if(void_ == cluster)
+            break;
+    }
+
+    std::array<int, CELLS> ranks;
+    const auto prototype_taken = taken;
+    const auto prototype_energy = energy;
+    for(auto rank = initial - 1; rank >= 0; --rank) {
+        const auto cell = Find(true);
+        Toggle(cell);
+        ranks[cell] = rank;
+    }
+    taken = prototype_taken;
+    energy = prototype_energy;
+    for(auto rank = initial; rank < static_cast<int>(CELLS); ++rank) {
+        const auto cell = Find(false);
+        Toggle(cell);
+        ranks[cell] = rank;
+    }
+
+    std::array<float, CELLS> mask;
+    for(std::size_t cell = 0; cell < CELLS; ++cell)
+        mask[cell] = (static_cast<float>(ranks[cell]) + 0.5f) /
+            static_cast<float>(CELLS);
+    return mask;
+}
+
+} // namespace
+
+auto Sampler::Mask() noexcept -> const std::array<float, CELLS>& {
+    static const auto mask = BuildMask();
+    return mask;
+}
+
+} // namespace ray
@@ -0,0 +1,505 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+
+#define RAY_TARGET(isa) [[gnu::target(isa), gnu::flatten]]
+
+import Aabb;
+import Bvh;
+import Cpu;
+import Material;
+import Object;
+import Ray;
+import Sampler;
+import Spheres;
+import Vector;
+
+module Scene;
+
+namespace ray {
+
+namespace {
+
+/**
+ * @brief Add spheres of object to container, descending into containers.
+ * @param object Object.
+ * @param spheres Container of spheres.
+ */
+void Flatten(const std::shared_ptr<Object>& object, Objects& spheres) {
+    if(dynamic_cast<const Sphere*>(object.get())) {
+        spheres.Add(object);
+    } else if(const auto objects = dynamic_cast<const Objects*>(object.get())) {
+        for(const auto& child : objects->GetObjects())
+            Flatten(child, spheres);
+    } else if(const auto bvh = dynamic_cast<const BVH*>(object.get())) {
+        for(const auto& child : bvh->GetObjects())
+            Flatten(child, spheres);
+    } else {
+        throw std::invalid_argument("Flat scene supports only spheres");
+    }
+}
+
+/**
+ * @brief Copy material to variant.
+ * @param material Material.
+ */
+auto ToVariant(const Material& material) -> Scene::MaterialVariant {
+    if(const auto lambertian = dynamic_cast<const Lambertian*>(&material))
+        return *lambertian;
+    if(const auto metal = dynamic_cast<const Metal*>(&material))
+        return *metal;
+    if(const auto dielectric = dynamic_cast<const Dielectric*>(&material))
+        return *dielectric;
+    if(const auto light = dynamic_cast<const DiffuseLight*>(&material))
+        return *light;
+    throw std::invalid_argument("Flat scene does not support material");
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief Lanes spheres of leaves are tested with.
+ *
+ * Leaves rarely hold more spheres than one SSE register does, so wider
+ * registers would only test more empty lanes.
+ */
+using LeafLanes = lanes::Sse;
+#else
+/*! @brief Lanes spheres of leaves are tested with. */
+using LeafLanes = lanes::Scalar;
+#endif
+
+/**
+ * @brief Get one minus cosine of half angle of cone sphere subtends from
+ * point, from squared sine, so that it stays exact for small distant spheres.
+ * @param distance2 Squared distance of point from center.
+ * @param radius Radius.
+ * @return Gap, zero if point is inside sphere.
+ */
+auto ConeGap(const float distance2, const float radius) noexcept -> float {
+    const auto sin2 = radius * radius / distance2;
+    if(!(sin2 < 1.0f))
+        return 0.0f;
+    return sin2 / (1.0f + std::sqrt(1.0f - sin2));
+}
+
+/*! @brief Index of sphere of ray that hits none. */
+constexpr auto NONE = std::numeric_limits<std::uint32_t>::max();
+
+/**
+ * @brief Bounds of packet of rays by interval arithmetic.
+ *
+ * Rounding is monotonic, so bounds computed from extreme origins and inverse
+ * directions hold for distances computed for each ray.
+ */
+class Frustum {
+private:
+    /*! @brief Lowest elements of origins. */
+    Vector3f origin_min;
+    /*! @brief Highest elements of origins. */
+    Vector3f origin_max;
+    /*! @brief Lowest elements of inverse directions. */
+    Vector3f inverse_min;
+    /*! @brief Highest elements of inverse directions. */
+    Vector3f inverse_max;
+    /*! @brief Whether all inverse directions are finite. */
+    bool finite{true};
+
+    /**
+     * @brief Bound products of two intervals.
+     * @return Pair of lowest and highest product.
+     */
+    static auto Multiply(const float a_min, const float a_max,
+        const float b_min, const float b_max) noexcept
+        -> std::pair<float, float> {
+        const auto p0 = a_min * b_min;
+        const auto p1 = a_min * b_max;
+        const auto p2 = a_max * b_min;
+        const auto p3 = a_max * b_max;
+        return {std::min({p0, p1, p2, p3}), std::max({p0, p1, p2, p3})};
+    }
+
+public:
+    /**
+     * @brief Constructor.
+     * @param rays Rays of packet, at least one.
+     */
+    explicit Frustum(const std::span<const Ray> rays) noexcept {
+        for(std::size_t i = 0; i < rays.size(); ++i) {
+            const auto origin = rays[i].Origin();
+            const auto direction = rays[i].Direction();
+            for(auto axis = 0; axis < 3; ++axis) {
+                const auto inverse = 1.0f / direction[axis];
+                finite = finite && std::isfinite(inverse);
+                origin_min[axis] = i == 0 ? origin[axis] :
+                    std::min(origin_min[axis], origin[axis]);
+                origin_max[axis] = i == 0 ? origin[axis] :
+                    std::max(origin_max[axis], origin[axis]);
+                inverse_min[axis] = i == 0 ? inverse :
+                    std::min(inverse_min[axis], inverse);
+                inverse_max[axis] = i == 0 ? inverse :
+                    std::max(inverse_max[axis], inverse);
+            }
+        }
+    }
+
+    /**
+     * @brief Check if all rays miss box.
+     * @param box Box.
+     * @param t_min Minimum distance.
+     */
+    [[nodiscard]] auto Misses(const AABB3f& box, const float t_min) const
+        noexcept -> bool {
+        if(!finite)
+            return false;
+        auto entry = t_min;
+        auto exit = std::numeric_limits<float>::infinity();
+        for(auto axis = 0; axis < 3; ++axis) {
+            const auto [t0_min, t0_max] = Multiply(
+                box.Min()[axis] - origin_max[axis],
+                box.Min()[axis] - origin_min[axis],
+                inverse_min[axis], inverse_max[axis]);
+            const auto [t1_min, t1_max] = Multiply(
+                box.Max()[axis] - origin_max[axis],
+                box.Max()[axis] - origin_min[axis],
+                inverse_min[axis], inverse_max[axis]);
+            entry = std::max(entry, std::min(t0_min, t1_min));
+            exit = std::min(exit, std::max(t0_max, t1_max));
+        }
+        return entry > exit;
+    }
+};
+
+/**
+ * @brief Find nearest sphere hit by each ray of packet, several rays at once.
+ *
+ * Each lane repeats operations of single ray tests, so it finds same sphere.
+ * @tparam L Lanes of register.
+ * @param nodes Nodes of hierarchy.
+ * @param spheres Spheres in order of leaves.
+ * @param rays Rays, at least one and at most Scene::PACKET_SIZE.
+ * @param interval Interval of minimum and maximum distances.
+ * @param closest Output distance of nearest hit of each ray.
+ * @param nearest Output index of nearest sphere of each ray, NONE on miss.
+ */
+template<typename L>
+void TracePacket(const std::span<const BVH::Node> nodes,
+    const SphereArrays& spheres, const std::span<const Ray> rays,
+    const Interval interval, float* const closest,
+    std::uint32_t* const nearest) noexcept {
+    using Register = typename L::Register;
+    constexpr auto W = std::size_t{L::WIDTH};
+    constexpr auto MAX_REGISTERS = (Scene::PACKET_SIZE + W - 1) / W;
+    const auto count = rays.size();
+    const auto registers = (count + W - 1) / W;
+
+    // Lanes past last ray repeat it, with negative distance bound never hit
+    const auto Gather = [&](const std::size_t r, const auto value) {
+        std::array<float, W> lanes;
+        for(std::size_t lane = 0; lane < W; ++lane) {
+            const auto i = r * W + lane;
+            lanes[lane] = value(rays[std::min(i, count - 1)], i < count);
+        }
+        return L::Load(lanes.data());
+    };
+    Register origin[3][MAX_REGISTERS];
+    Register direction[3][MAX_REGISTERS];
+    Register inverse[3][MAX_REGISTERS];
+    Register a[MAX_REGISTERS];
+    Register bound[MAX_REGISTERS];
+    Register index[MAX_REGISTERS];
+    for(std::size_t r = 0; r < registers; ++r) {
+        for(auto axis = 0; axis < 3; ++axis) {
+            origin[axis][r] = Gather(r, [&](const Ray& ray, bool) {
+                return ray.Origin()[axis];
+            });
+            direction[axis][r] = Gather(r, [&](const Ray& ray, bool) {
+                return ray.Direction()[axis];
+            });
+            inverse[axis][r] = Gather(r, [&](const Ray& ray, bool) {
+                return 1.0f / ray.Direction()[axis];
+            });
+        }
+        a[r] = Gather(r, [](const Ray& ray, bool) {
+            return ray.Direction().Length2();
+        });
+        bound[r] = Gather(r, [&](const Ray&, const bool active) {
+            return active ? interval.Max() :
+                -std::numeric_limits<float>::infinity();
+        });
+        index[r] = L::SetBits(NONE);
+    }
+    const auto minimum = L::Set(interval.Min());
+
+    const Frustum frustum(rays);
+    const auto Visits = [&](const AABB3f& box) {
+        if(frustum.Misses(box, interval.Min()))
+            return false;
+        Register low[3], high[3];
+        for(auto axis = 0; axis < 3; ++axis) {
+            low[axis] = L::Set(box.Min()[axis]);
+            high[axis] = L::Set(box.Max()[axis]);
+        }
+        for(std::size_t r = 0; r < registers; ++r) {
+            auto entry = minimum;
+            auto exit = bound[r];
+            for(auto axis = 0; axis < 3; ++axis) {
+                const auto t0 = L::Mul(L::Sub(low[axis], origin[axis][r]),
+                    inverse[axis][r]);
+                const auto t1 = L::Mul(L::Sub(high[axis], origin[axis][r]),
+                    inverse[axis][r]);
+                entry = L::Max(L::Min(t0, t1), entry);
+                exit = L::Min(L::Max(t0, t1), exit);
+            }
+            if(L::Bits(L::LessEqual(entry, exit)) != 0)
+                return true;
+        }
+        return false;
+    };
+    const auto Intersect = [&](const std::uint32_t sphere) {
+        const auto center_x = L::Set(spheres.x[sphere]);
+        const auto center_y = L::Set(spheres.y[sphere]);
+        const auto center_z = L::Set(spheres.z[sphere]);
+        const auto radius = L::Set(spheres.radius[sphere]);
+        for(std::size_t r = 0; r < registers; ++r) {
+            const auto x = L::Sub(center_x, origin[0][r]);
+            const auto y = L::Sub(center_y, origin[1][r]);
+            const auto z = L::Sub(center_z, origin[2][r]);
+            const auto b = L::Add(L::Add(L::Mul(x, direction[0][r]),
+                L::Mul(y, direction[1][r])), L::Mul(z, direction[2][r]));
+            const auto c = L::Sub(L::Add(L::Add(L::Mul(x, x), L::Mul(y, y)),
+                L::Mul(z, z)), L::Mul(radius, radius));
+            const auto root = L::Sqrt(L::Sub(L::Mul(b, b), L::Mul(a[r], c)));
+            const auto near = L::Div(L::Sub(b, root), a[r]);
+            const auto far = L::Div(L::Add(b, root), a[r]);
+            const auto near_hit = L::And(L::Less(minimum, near),
+                L::Less(near, bound[r]));
+            const auto far_hit = L::And(L::Less(minimum, far),
+                L::Less(far, bound[r]));
+            const auto hit = L::Or(near_hit, far_hit);
+            if(L::Bits(hit) == 0)
+                continue;
+            bound[r] = L::Select(hit, L::Select(near_hit, near, far),
+                bound[r]);
+            index[r] = L::Select(hit, L::SetBits(sphere), index[r]);
+        }
+    };
+
+    // Children are ordered by direction of first ray
+    const auto direction_first = rays.front().Direction();
+    std::array<std::uint32_t, BVH::MAX_DEPTH> stack;
+    std::size_t size{0};
+    std::uint32_t node_index{0};
+    while(!nodes.empty()) {
+        const auto& node = nodes[node_index];
+        if(Visits(node.box)) {
+            if(node.count > 0) {
+                for(auto i = node.offset; i < node.offset + node.count; ++i)
+                    Intersect(i);
+            } else {
+                const auto separation = nodes[node.offset + 1].box.Centroid() -
+                    nodes[node.offset].box.Centroid();
+                auto axis = 0;
+                for(auto i = 1; i < 3; ++i)
+                    if(std::abs(separation[i]) > std::abs(separation[axis]))
+                        axis = i;
+                const auto flip = separation[axis] * direction_first[axis] <
+                    0.0f;
+                stack[size++] = node.offset + (flip ? 0 : 1);
+                node_index = node.offset + (flip ? 1 : 0);
+                continue;
+            }
+        }
+        if(size == 0)
+            break;
+        node_index = stack[--size];
+    }
+
+    for(std::size_t r = 0; r < registers; ++r) {
+        std::array<float, W> distances, indices;
+        L::Store(distances.data(), bound[r]);
+        L::Store(indices.data(), index[r]);
+        for(std::size_t lane = 0; lane < W && r * W + lane < count; ++lane) {
+            closest[r * W + lane] = distances[lane];
+            nearest[r * W + lane] = std::bit_cast<std::uint32_t>(
+                indices[lane]);
+        }
+    }
+}
+
+/*! @brief Function type of packet kernel. */
+using PacketKernel = void(std::span<const BVH::Node>, const SphereArrays&,
+    std::span<const Ray>, Interval, float*, std::uint32_t*) noexcept;
+
+#if defined(__x86_64__) || defined(__i386__)
+[[gnu::flatten]] void TracePacketBaseline(
+    const std::span<const BVH::Node> nodes, const SphereArrays& spheres,
+    const std::span<const Ray> rays, const Interval interval,
+    float* const closest, std::uint32_t* const nearest) noexcept {
+    TracePacket<lanes::Sse>(nodes, spheres, rays, interval, closest, nearest);
+}
+
+RAY_TARGET("avx2,fma") void TracePacketAvx2(
+    const std::span<const BVH::Node> nodes, const SphereArrays& spheres,
+    const std::span<const Ray> rays, const Interval interval,
+    float* const closest, std::uint32_t* const nearest) noexcept {
+    TracePacket<lanes::Avx>(nodes, spheres, rays, interval, closest, nearest);
+}
+
+RAY_TARGET("avx512f") void TracePacketAvx512(
+    const std::span<const BVH::Node> nodes, const SphereArrays& spheres,
+    const std::span<const Ray> rays, const Interval interval,
+    float* const closest, std::uint32_t* const nearest) noexcept {
+    TracePacket<lanes::Avx512>(nodes, spheres, rays, interval, closest,
+        nearest);
+}
+
+/*! @brief Packet kernels, SSE of baseline serving SSE4.2 too. */
+constexpr math::cpu::Kernels<PacketKernel> PACKET{TracePacketBaseline,
+    TracePacketBaseline, TracePacketAvx2, TracePacketAvx512};
+#else
+[[gnu::flatten]] void TracePacketBaseline(
+    const std::span<const BVH::Node> nodes, const SphereArrays& spheres,
+    const std::span<const Ray> rays, const Interval interval,
+    float* const closest, std::uint32_t* const nearest) noexcept {
+    TracePacket<lanes::Scalar>(nodes, spheres, rays, interval, closest,
+        nearest);
+}
+
+/*! @brief Packet kernels, one lane on every level. */
+constexpr math::cpu::Kernels<PacketKernel> PACKET{TracePacketBaseline,
+    TracePacketBaseline, TracePacketBaseline, TracePacketBaseline};
+#endif
+
+} // namespace
+
+Scene::Scene(const Objects& objects, const BVH::Method method) {
+    Objects flat;
+    for(const auto& object : objects.GetObjects())
+        Flatten(object, flat);
+
+    const BVH bvh(flat, method);
+    statistics = bvh.GetStatistics();
+    nodes.assign(bvh.GetNodes().begin(), bvh.GetNodes().end());
+
+    const auto count = bvh.GetObjects().size();
+    spheres.x.reserve(count);
+    spheres.y.reserve(count);
+    spheres.z.reserve(count);
+    spheres.radius.reserve(count);
+    spheres.material.reserve(count);
+    std::unordered_map<const Material*, std::uint32_t> indices;
+    for(const auto& object : bvh.GetObjects()) {
+        const auto& sphere = static_cast<const Sphere&>(*object);
+        const auto& material = sphere.GetMaterial();
+        const auto [index, added] = indices.try_emplace(material.get(),
+            static_cast<std::uint32_t>(materials.size()));
+        if(added)
+            materials.push_back(ToVariant(*material));
+        spheres.x.push_back(sphere.GetCenter()[0]);
+        spheres.y.push_back(sphere.GetCenter()[1]);
+        spheres.z.push_back(sphere.GetCenter()[2]);
+        spheres.radius.push_back(sphere.GetRadius());
+        spheres.material.push_back(index->second);
+        if(std::holds_alternative<DiffuseLight>(materials[index->second]))
+            lights.push_back(static_cast<std::uint32_t>(spheres.x.size() - 1));
+    }
+    for(auto* array : {&spheres.x, &spheres.y, &spheres.z, &spheres.radius})
+        array->resize(count + SphereArrays::PADDING, 0.0f);
+}
+
+auto Scene::CheckHit(const Ray& ray, const Interval interval) const noexcept
+    -> std::optional<Hit> {
+    const SphereArrays arrays{spheres.x.data(), spheres.y.data(),
+        spheres.z.data(), spheres.radius.data()};
+    const lanes::SphereTest<LeafLanes> test(ray, interval.Min());
+    auto closest = interval.Max();
+    std::optional<std::uint32_t> nearest;
+    BVH::Traverse(nodes, ray, interval.Min(), closest,
+        [&](const std::uint32_t first, const std::uint32_t count) {
+            if(const auto hit = test.Nearest(arrays, first, count, closest))
+                nearest = hit;
+        });
+    if(!nearest)
+        return std::nullopt;
+    const auto i = *nearest;
+    return Hit{Sphere::SurfaceAt(Vector3f{spheres.x[i], spheres.y[i],
+        spheres.z[i]}, spheres.radius[i], ray, closest),
+        spheres.material[i], i};
+}
+
+void Scene::CheckHits(const std::span<const Ray> rays,
+    const Interval interval, const std::span<std::optional<Hit>> hits) const
+    noexcept {
+    const SphereArrays arrays{spheres.x.data(), spheres.y.data(),
+        spheres.z.data(), spheres.radius.data()};
+    std::array<float, PACKET_SIZE> closest;
+    std::array<std::uint32_t, PACKET_SIZE> nearest;
+    for(std::size_t first = 0; first < rays.size(); first += PACKET_SIZE) {
+        const auto packet = rays.subspan(first,
+            std::min(PACKET_SIZE, rays.size() - first));
+        PACKET.Select()(nodes, arrays, packet, interval, closest.data(),
+            nearest.data());
+        for(std::size_t i = 0; i < packet.size(); ++i) {
+            const auto sphere = nearest[i];
+            if(sphere == NONE) {
+                hits[first + i] = std::nullopt;
+                continue;
+            }
+            hits[first + i] = Hit{Sphere::SurfaceAt(Vector3f{spheres.x[sphere],
+                spheres.y[sphere], spheres.z[sphere]}, spheres.radius[sphere],
+                packet[i], closest[i]), spheres.material[sphere], sphere};
+        }
+    }
+}
+
+auto Scene::SampleLight(const Vector3f& point, const float select,
+    const std::array<float, 2>& u) const noexcept
+    -> std::optional<LightSample> {
+    if(lights.empty())
+        return std::nullopt;
+    const auto sphere = lights[std::min(lights.size() - 1,
+        static_cast<std::size_t>(select * static_cast<float>(lights.size())))];
+    const auto axis = Vector3f{spheres.x[sphere], spheres.y[sphere],
+        spheres.z[sphere]} - point;
+    const auto distance2 = axis.Length2();
+    const auto gap = ConeGap(distance2, spheres.radius[sphere]);
+    if(gap <= 0.0f)
+        return std::nullopt;
+    return LightSample{
+        .direction = warp::Cone(axis / std::sqrt(distance2), gap, u),
+        .pdf = 1.0f / (2.0f * std::numbers::pi_v<float> * gap *
+            static_cast<float>(lights.size())),
+        .sphere = sphere
+    };
+}
+
+auto Scene::LightPdf(const Vector3f& point, const Hit& hit) const noexcept
+    -> float {
+    if(!std::holds_alternative<DiffuseLight>(materials[hit.material]))
+        return 0.0f;
+    const auto sphere = hit.sphere;
+    const auto gap = ConeGap((Vector3f{spheres.x[sphere], spheres.y[sphere],
+        spheres.z[sphere]} - point).Length2(), spheres.radius[sphere]);
+    if(gap <= 0.0f)
+        return 0.0f;
+    return 1.0f / (2.0f * std::numbers::pi_v<float> * gap *
+        static_cast<float>(lights.size()));
+}
+
+} // namespace ray
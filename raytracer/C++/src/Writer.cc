@@ -0,0 +1,242 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+import Material;
+
+module Writer;
+
+namespace ray {
+
+namespace {
+
+static_assert(sizeof(Color) == 3 * sizeof(float),
+    "colors must be packed channels to be converted as one array");
+
+/*! @brief Operation of QOI encoder, index into pixels seen. */
+constexpr std::uint8_t OP_INDEX = 0x00;
+/*! @brief Operation of QOI encoder, small difference from previous. */
+constexpr std::uint8_t OP_DIFF = 0x40;
+/*! @brief Operation of QOI encoder, difference relative to green. */
+constexpr std::uint8_t OP_LUMA = 0x80;
+/*! @brief Operation of QOI encoder, run of previous pixel. */
+constexpr std::uint8_t OP_RUN = 0xc0;
+/*! @brief Operation of QOI encoder, whole pixel. */
+constexpr std::uint8_t OP_RGB = 0xfe;
+/*! @brief Longest run of QOI encoder. */
+constexpr auto MAX_RUN = 62;
+
+} // namespace
+
+Writer::Writer(std::ostream& file, const int width, const int height,
+    const Format format) : file(file), width{width}, height{height},
+    format{format} {
+    const auto size = std::to_string(width) + ' ' + std::to_string(height);
+    if(format == Format::QOI) {
+        buffer = {'q', 'o', 'i', 'f'};
+        for(const auto& value : {width, height})
+            for(auto shift = 24; shift >= 0; shift -= 8)
+                buffer.push_back(static_cast<std::uint8_t>(
+                    static_cast<std::uint32_t>(value) >> shift));
+        buffer.insert(buffer.end(), {3, 0});
+    } else {
+        // Little endian floats are marked by negative scale
+        const auto header = format == Format::PPM ? "P6\n" + size +
+            "\n255\n" : "PF\n" + size + (std::endian::native ==
+            std::endian::little ? "\n-1.0\n" : "\n1.0\n");
+        buffer.assign(header.begin(), header.end());
+    }
+    header_size = buffer.size();
+    if(format == Format::PFM)
+        origin = file.tellp();
+}
+
+void Writer::Append(const std::span<const Color> colors) {
+    const auto count = static_cast<int>(colors.size()) / width;
+    if(format == Format::PFM) {
+        // Header stays at start, rows go where they belong from end back
+        const auto row = 3 * sizeof(float) * static_cast<std::size_t>(width);
+        if(!buffer.empty())
+            Flush();
+        buffer.resize(row * count);
+        for(auto y = 0; y < count; ++y)
+            std::memcpy(buffer.data() + row * (count - 1 - y),
+                colors.data() + static_cast<std::size_t>(y) * width, row);
+        file.seekp(origin + static_cast<std::streamoff>(header_size +
+            row * (height - rows - count)));
+        Flush();
+    } else if(format == Format::PPM) {
+        const auto start = buffer.size();
+        buffer.resize(start + 3 * colors.size());
+        Quantize(colors, std::span(buffer).subspan(start));
+        Flush();
+    } else {
+        bytes.resize(3 * colors.size());
+        Quantize(colors, bytes);
+        EncodeQoi(bytes);
+        Flush();
+    }
+    rows += count;
+}
+
+void Writer::Append(const std::span<const std::uint8_t> channels) {
+    if(format == Format::PFM)
+        throw std::invalid_argument("Float format for 8-bit image");
+    if(format == Format::QOI)
+        EncodeQoi(channels);
+    else
+        buffer.insert(buffer.end(), channels.begin(), channels.end());
+    Flush();
+    rows += static_cast<int>(channels.size() / 3) / width;
+}
+
+void Writer::Finish() {
+    if(format == Format::QOI) {
+        if(run > 0)
+            buffer.push_back(static_cast<std::uint8_t>(OP_RUN | (run - 1)));
+        run = 0;
+        buffer.insert(buffer.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+    }
+    Flush();
+    file.flush();
+    if(!file)
+        throw std::runtime_error("Failed to write image file");
+}
+
+void Writer::EncodeQoi(const std::span<const std::uint8_t> channels) {
+    // Alpha is always opaque, so it only enters hashes
+    buffer.reserve(buffer.size() + channels.size() / 3 * 4);
+    for(std::size_t i = 0; i + 2 < channels.size(); i += 3) {
+        const std::array<std::uint8_t, 3> pixel{channels[i],
+            channels[i + 1], channels[i + 2]};
+        if(pixel == previous) {
+            if(++run == MAX_RUN) {
+                buffer.push_back(static_cast<std::uint8_t>(OP_RUN |
+                    (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if(run > 0) {
+            buffer.push_back(static_cast<std::uint8_t>(OP_RUN | (run - 1)));
+            run = 0;
+        }
+
+        const auto hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 +
+            255 * 11) % 64;
+        const std::array<std::uint8_t, 4> opaque{pixel[0], pixel[1],
+            pixel[2], 255};
+        if(seen[hash] == opaque) {
+            buffer.push_back(static_cast<std::uint8_t>(OP_INDEX | hash));
+        } else {
+            seen[hash] = opaque;
+            const auto Difference = [&](const std::size_t channel) noexcept {
+                return static_cast<int>(static_cast<std::int8_t>(
+                    pixel[channel] - previous[channel]));
+            };
+            const auto r = Difference(0);
+            const auto g = Difference(1);
+            const auto b = Difference(2);
+            const auto r_g = r - g;
+            const auto b_g = b - g;
+            if(r >= -2 && r <= 1 && g >= -2 && g <= 1 && b >= -2 && b <= 1) {
+                buffer.push_back(static_cast<std::uint8_t>(OP_DIFF |
+                    (r + 2) << 4 | (g + 2) << 2 | (b + 2)));
+            } else if(r_g >= -8 && r_g <= 7 && g >= -32 && g <= 31 &&
+                b_g >= -8 && b_g <= 7) {
+                buffer.push_back(static_cast<std::uint8_t>(OP_LUMA |
+                    (g + 32)));
+                buffer.push_back(static_cast<std::uint8_t>((r_g + 8) << 4 |
+                    (b_g + 8)));
+            } else {
+                buffer.insert(buffer.end(), {OP_RGB, pixel[0], pixel[1],
+                    pixel[2]});
+            }
+        }
+        previous = pixel;
+    }
+}
+
+void Writer::Flush() {
+    file.write(reinterpret_cast<const char*>(buffer.data()),
+        static_cast<std::streamsize>(buffer.size()));
+    if(!file)
+        throw std::runtime_error("Failed to write image file");
+    buffer.clear();
+}
+
+auto Writer::Extension(const Format format) noexcept -> std::string_view {
+    switch(format) {
+    case Format::PFM:
+        return ".pfm";
+    case Format::QOI:
+        return ".qoi";
+    default:
+        return ".ppm";
+    }
+}
+
+void Writer::Quantize(const std::span<const Color> colors,
+    const std::span<std::uint8_t> bytes) noexcept {
+    constexpr auto LIMIT = 1.0f - 1e-4f;
+    constexpr auto SCALE = 255.999f;
+    const auto channels = std::span(reinterpret_cast<const float*>(
+        colors.data()), 3 * colors.size());
+    std::size_t i = 0;
+#if defined(__SSE2__)
+    // Sixteen channels at a time, since std::sqrt may set errno, which keeps
+    // compilers from vectorizing loop. Same results as loop below.
+    const auto zero = _mm_setzero_ps();
+    const auto limit = _mm_set1_ps(LIMIT);
+    const auto scale = _mm_set1_ps(SCALE);
+    const auto Convert = [&](const std::size_t offset) noexcept {
+        // Maximum takes zero for NaN
+        const auto value = _mm_max_ps(_mm_loadu_ps(channels.data() + offset),
+            zero);
+        return _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_sqrt_ps(value),
+            limit), scale));
+    };
+    for(; i + 16 <= channels.size(); i += 16)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes.data() + i),
+            _mm_packus_epi16(_mm_packs_epi32(Convert(i), Convert(i + 4)),
+            _mm_packs_epi32(Convert(i + 8), Convert(i + 12))));
+#endif
+    for(; i < channels.size(); ++i) {
+        const auto value = channels[i] > 0.0f ? channels[i] : 0.0f;
+        bytes[i] = static_cast<std::uint8_t>(SCALE *
+            std::min(std::sqrt(value), LIMIT));
+    }
+}
+
+void Writer::Write(std::ostream& file, const std::span<const Color> colors,
+    const int width, const int height, const Format format) {
+    Writer writer(file, width, height, format);
+    writer.Append(colors);
+    writer.Finish();
+}
+
+void Writer::Write(std::ostream& file,
+    const std::span<const std::uint8_t> channels, const int width,
+    const int height, const Format format) {
+    Writer writer(file, width, height, format);
+    writer.Append(channels);
+    writer.Finish();
+}
+
+} // namespace ray
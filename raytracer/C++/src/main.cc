@@ -1,14 +1,77 @@
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <memory>
+#include <string>
 
+#include <cmath>
+
+import Bvh;
 import Camera;
 import Material;
 import Object;
+import Random;
+import Sampler;
+import Scene;
+import Writer;
 
 using namespace ray;
 
-/*! @brief Main function. */
-int main() {
+/*! @brief Camera orientation. */
+constexpr auto ORIENTATION = [] {
+    Camera::Orientation orientation;
+    orientation.look_from = {-2.0f, 2.0f, 1.0f};
+    orientation.look_at = {0.0f, 0.0f, -1.0f};
+    orientation.up = {0.0f, 1.0f, 0.0f};
+    return orientation;
+}();
+
+/*! @brief Output image. */
+constexpr auto IMAGE = [] {
+    Camera::Image image;
+    image.image_width = 640;
+    image.aspect_ratio = 16.0f / 9.0f;
+    return image;
+}();
+
+/**
+ * @brief Scatter small spheres on ground, spread wider the more there are.
+ * @param objects Container to add spheres to.
+ * @param count Number of spheres.
+ * @param materials Materials to pick from.
+ */
+void AddSpheres(Objects& objects, const std::size_t count,
+    const std::array<std::shared_ptr<Material>, 6>& materials) {
+    const auto side = std::max(8.0f, 0.02f * std::sqrt(
+        static_cast<float>(count)));
+    const auto radius = std::min(0.05f, 0.4f * side / std::sqrt(
+        static_cast<float>(count)));
+    for(std::size_t i = 0; i < count; ++i) {
+        const auto x = Random::Number(-0.5f, 0.5f) * side;
+        const auto z = Random::Number(-0.5f, 0.5f) * side;
+        const auto ground = -100.5f + std::sqrt(std::max(0.0f,
+            10000.0f - x * x - z * z));
+        objects.Add(std::make_shared<Sphere>(
+            Vector3f{x, ground + radius, z - 1.0f}, radius,
+            materials[i % materials.size()]));
+    }
+}
+
+/**
+ * @brief Main function.
+ *
+ * Optional first argument adds that many small spheres, to stress hierarchy,
+ * optional second argument "morton" builds it faster but traces it slower,
+ * optional third argument "wavefront" renders with wavefront integrator,
+ * "adaptive" samples noisy pixels more, writing heatmap of samples, and
+ * "progressive" renders 256 samples per pixel in passes, saving checkpoint
+ * every ten seconds and resuming from it if there is one, and
+ * optional fourth argument "independent", "stratified" or "blue" replaces
+ * default Sobol sampler, optional fifth argument "pfm" or "qoi" replaces
+ * default binary PPM image and optional sixth argument "lights" adds small
+ * bright lights, which lights are sampled toward.
+ */
+int main(int argc, char* argv[]) {
     std::ios_base::sync_with_stdio(false);
 
     Objects objects;
@@ -53,17 +116,62 @@ int main() {
     objects.Add(std::make_shared<Sphere>(Vector3f{-4.7f, 2.4f, 3.1f}, 3.0f,
         material_gold));
 
-    Camera::Orientation orientation;
-    orientation.look_from = {-2.0f, 2.0f, 1.0f};
-    orientation.look_at = {0.0f, 0.0f, -1.0f};
-    orientation.up = {0.0f, 1.0f, 0.0f};
+    if(argc > 6 && std::string(argv[6]) == "lights") {
+        const auto material_warm = std::make_shared<DiffuseLight>(
+            Color{60.0f, 40.0f, 20.0f});
+        const auto material_cold = std::make_shared<DiffuseLight>(
+            Color{10.0f, 20.0f, 60.0f});
+        objects.Add(std::make_shared<Sphere>(Vector3f{0.3f, -0.42f, -0.2f},
+            0.04f, material_warm));
+        objects.Add(std::make_shared<Sphere>(Vector3f{-0.6f, -0.44f, -1.6f},
+            0.05f, material_cold));
+        objects.Add(std::make_shared<Sphere>(Vector3f{0.7f, 0.7f, -1.4f},
+            0.03f, material_warm));
+    }
 
-    Camera::Image image;
-    image.image_width = 640;
-    image.aspect_ratio = 16.0f / 9.0f;
-    
-    auto camera = Camera(orientation, image);
-    camera.Render(objects);
+    if(argc > 1)
+        AddSpheres(objects, std::stoul(argv[1]), {material_arctic,
+            material_blue, material_light, material_bronze, material_gold,
+            material_glass});
+
+    const auto method = argc > 2 && std::string(argv[2]) == "morton" ?
+        BVH::Method::MORTON : BVH::Method::SAH;
+    const Scene scene(objects, method);
+    const auto& statistics = scene.GetStatistics();
+    std::cout << "Built hierarchy of " << statistics.objects <<
+        " objects in " << statistics.seconds << " s: " << statistics.nodes <<
+        " nodes, " << statistics.leaves << " leaves, depth " <<
+        statistics.depth << ", cost " << statistics.cost << std::endl;
+
+    Camera::Sampling sampling;
+    Camera::Scheduling scheduling;
+    if(argc > 3 && std::string(argv[3]) == "wavefront")
+        scheduling.integrator = Camera::Integrator::WAVEFRONT;
+    if(argc > 3 && std::string(argv[3]) == "adaptive") {
+        sampling.samples = 32;
+        sampling.target_error = 0.01f;
+    }
+    if(argc > 3 && std::string(argv[3]) == "progressive") {
+        sampling.samples = 256;
+        scheduling.progressive = true;
+        scheduling.checkpoint_interval = 10.0f;
+    }
+    if(argc > 4) {
+        const auto sampler = std::string(argv[4]);
+        if(sampler == "independent")
+            sampling.sampler = Sampler::Method::INDEPENDENT;
+        else if(sampler == "stratified")
+            sampling.sampler = Sampler::Method::STRATIFIED;
+        else if(sampler == "blue")
+            sampling.sampler = Sampler::Method::BLUE_NOISE;
+    }
+    auto image = IMAGE;
+    if(argc > 5 && std::string(argv[5]) == "pfm")
+        image.format = Writer::Format::PFM;
+    if(argc > 5 && std::string(argv[5]) == "qoi")
+        image.format = Writer::Format::QOI;
+    auto camera = Camera(ORIENTATION, image, {}, sampling, scheduling);
+    camera.Render(scene);
 
     return 0;
 }
@@ -38,5 +38,5 @@ exe clang++ $FLAGS src/main.cc $MODULES -c -o bin/main.o
 exe clang++ $FLAGS bin/Image.pcm $MODULES -c -o bin/Image.o
 exe clang++ $FLAGS bin/Model.pcm $MODULES -c -o bin/Model.o
 exe clang++ $FLAGS bin/Shader.pcm $MODULES -c -o bin/Shader.o
-exe clang++ bin/main.o bin/Image.o bin/Image-src.o bin/Model.o bin/Model-src.o bin/Shader.o bin/Shader-src.o -o renderer
+exe clang++ bin/main.o bin/Image.o bin/Image-src.o bin/Model.o bin/Model-src.o bin/Shader.o bin/Shader-src.o $LIB/libmath.a -o renderer
 exit 0
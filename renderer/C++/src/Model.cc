@@ -1,7 +1,11 @@
 module;
 
 #include <fstream>
+#include <span>
 #include <sstream>
+#include <vector>
+
+import Batch;
 
 module Model;
 
@@ -13,6 +17,7 @@ auto Model::Load(const std::string& filename) -> Model {
     if(in.fail())
         throw ModelError("Error loading model file " + filename);
 
+    std::vector<Vector3f> normals;
     std::string line;
     while(!in.eof()) {
         std::getline(in, line);
@@ -31,7 +36,7 @@ auto Model::Load(const std::string& filename) -> Model {
             Vector3f n;
             for(auto i: {0, 1, 2})
                 iss >> n[i];
-            model.normals.emplace_back(n.Normalize());
+            normals.push_back(n);
 
         } else if(!line.compare(0, 3, "vt ")) {
             iss >> trash >> trash;
@@ -55,6 +60,11 @@ auto Model::Load(const std::string& filename) -> Model {
         }
     }
 
+    math::batch::Normalize(std::span<Vector3f>(normals));
+    model.normals.reserve(normals.size());
+    for(const auto& normal : normals)
+        model.normals.emplace_back(normal);
+
     auto dot = filename.find_last_of('.');
     model.texture.ReadTgaFile(filename.substr(0, dot) + ".tga");
     return model;
@@ -1,10 +1,10 @@
 module;
 
 #include <array>
-#include <limits>
 
 #include <cmath>
 
+import Aabb;
 import Image;
 
 module Shader;
@@ -34,25 +34,17 @@ void Shader::LoadTriangle(const std::size_t face) {
 }
 
 void Shader::RenderTriangle(Image& image) {
-    for(auto i: {0, 1, 2}) {
-        vertices[i][0] = static_cast<int>((vertices[i][0] + 1.0f) *
-            image.GetWidth() / 2.0f + 0.5f);
-        vertices[i][1] = static_cast<int>((vertices[i][1] + 1.0f) *
-            image.GetHeight() / 2.0f + 0.5f);
-    }
+    for(auto i: {0, 1, 2})
+        for(auto j: {0, 1})
+            vertices[i][j] = static_cast<int>(vertices[i][j] + 0.5f);
 
-    Vector2f bbox_min{std::numeric_limits<float>::max(),
-        std::numeric_limits<float>::max()};
-    Vector2f bbox_max{-std::numeric_limits<float>::max(),
-        -std::numeric_limits<float>::max()};
-    Vector2f clamp{image.GetWidth() - 1, image.GetHeight() - 1};
-    for(auto i: {0, 1, 2}) {
-        for(auto j: {0, 1}) {
-            bbox_min[j] = std::max(0.0f, std::min(bbox_min[j], vertices[i][j]));
-            bbox_max[j] = std::min(clamp[j],
-                std::max(bbox_max[j], vertices[i][j]));
-        }
-    }
+    math::AABB<float, 2> bbox;
+    for(auto i: {0, 1, 2})
+        bbox = bbox.Union(Vector2f{vertices[i][0], vertices[i][1]});
+    bbox = bbox.Intersection(math::AABB<float, 2>(Vector2f{0.0f, 0.0f},
+        Vector2f{image.GetWidth() - 1, image.GetHeight() - 1}));
+    const auto bbox_min = bbox.Min();
+    const auto bbox_max = bbox.Max();
 
     Vector3f p;
     for(p[0] = bbox_min[0]; p[0] <= bbox_max[0]; ++p[0]) {
@@ -63,9 +55,9 @@ void Shader::RenderTriangle(Image& image) {
             p[2] = 0;
             for(auto i: {0, 1, 2})
                 p[2] += vertices[i][2] * barycentric[i];
-            Vector2f uv{};
-            for(auto i: {0, 1, 2})
-                uv += texels[i] * barycentric[i];
+            const Vector2f uv = math::Lazy(texels[0]) * barycentric[0] +
+                math::Lazy(texels[1]) * barycentric[1] +
+                math::Lazy(texels[2]) * barycentric[2];
             const auto diffuse = model.GetTexturePixel(uv);
             image.SetPixel(p[0], p[1], p[2], diffuse);
         }
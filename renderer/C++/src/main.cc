@@ -1,6 +1,7 @@
 #include <iostream>
 
 import Image;
+import Matrix;
 import Model;
 import Shader;
 
@@ -21,6 +22,8 @@ int main(const int argc, const char* argv[]) {
     Image image(WIDTH, HEIGHT, Image::Format::RGB);
     for(auto arg = 1; arg < argc; ++arg) {
         auto model = Model::Load("../.obj/" + std::string{argv[arg]});
+        model.Transform(math::Viewport(0.0f, 0.0f, static_cast<float>(WIDTH),
+            static_cast<float>(HEIGHT)));
         Shader shader(model);
         for(auto i = 0u; i < model.FacesCount(); ++i) {
             shader.LoadTriangle(i);